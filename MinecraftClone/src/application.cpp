@@ -1,6 +1,18 @@
 #include "application.hpp"
+#include "gl_trace.hpp"
+
+#include <chrono>
 
 namespace MC {
+	namespace {
+		// Time since start, which is then moved up to now for the next stage
+		u64 EndStage(std::chrono::steady_clock::time_point& start) {
+			auto now = std::chrono::steady_clock::now();
+			u64 microseconds = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+			start = now;
+			return microseconds;
+		}
+	}
 
 	Application::Application(f32 delta_time, std::unique_ptr<ThreadPool> tp)
 		: m_thread_pool(std::move(tp))
@@ -14,7 +26,7 @@ namespace MC {
 	}
 
 	void Application::Start() {
-		if (!m_window) {
+		if (!m_window && !m_headless) {
 			LOG_FATAL("Window has not been created!");
 		}
 
@@ -30,14 +42,33 @@ namespace MC {
 	}
 
 	void Application::Update() {
+		auto frame_start = std::chrono::steady_clock::now();
+		auto stage_start = frame_start;
+
 		RunUpdateFunctions();
+		m_frame_timings.update_functions = EndStage(stage_start);
 		m_scene->UpdateChunksAroundPlayer();
+		m_frame_timings.chunk_streaming = EndStage(stage_start);
 		m_scene->UpdateChunks();
-		m_window->Update();
-		m_renderer->Render(*m_thread_pool, *m_scene);
+		m_frame_timings.chunk_updates = EndStage(stage_start);
+
+		if (!m_headless) {
+			m_window->Update();
+			m_frame_timings.present = EndStage(stage_start);
+			m_renderer->Render(*m_thread_pool, *m_scene);
+			GLTrace::EndFrame();
+			m_frame_timings.render = EndStage(stage_start);
+		}
+
+		m_frame_timings.frame = EndStage(frame_start);
 	}
 
 	void Application::Shutdown() {
+		if (m_headless) {
+			m_running = false;
+			return;
+		}
+
 		// Shutdown window for now
 		m_window->Shutdown();
 	}
@@ -138,8 +169,8 @@ namespace MC {
 	}
 
 
-	Application& Application::CreateWindow(const std::string& title, i32 width, i32 height) {
-		m_window = std::make_unique<Window>(title, width, height, *m_event_handler);
+	Application& Application::CreateWindow(const std::string& title, i32 width, i32 height, WindowMode mode) {
+		m_window = std::make_unique<Window>(title, width, height, *m_event_handler, mode);
 		// Initialize scene after OpenGL has been initialized
 		m_scene->InitializeScene();
 		m_renderer = std::make_unique<Renderer>();
@@ -149,6 +180,14 @@ namespace MC {
 		return *this;
 	}
 
+	Application& Application::CreateHeadless() {
+		m_headless = true;
+		m_scene->InitializeHeadlessScene();
+		return *this;
+	}
+
+	bool Application::IsHeadless() const { return m_headless; }
+
 	Scene& Application::GetScene() const { return *m_scene; };
 
 	Window& Application::GetWindow() const { return *m_window; }
@@ -161,10 +200,12 @@ namespace MC {
 
 	EventHandler& Application::GetEventHandler() const { return *m_event_handler; }
 
-	const bool Application::Running() const { return m_window->Running(); }
+	const bool Application::Running() const { return m_headless ? m_running.load() : m_window->Running(); }
 
 	ThreadPool& Application::GetThreadPool() const { return *m_thread_pool; }
 
 	void Application::SetDeltaTime(f32 delta_time) { m_delta_time = delta_time; }
 
+	const FrameTimings& Application::GetFrameTimings() const { return m_frame_timings; }
+
 } // namespace Spark
\ No newline at end of file
@@ -8,6 +8,16 @@
 #include "scene.hpp"
 
 namespace MC {
+	// CPU time spent in each stage of the last frame, in microseconds
+	struct FrameTimings {
+		u64 update_functions = 0;
+		u64 chunk_streaming = 0;  // UpdateChunksAroundPlayer
+		u64 chunk_updates = 0;    // UpdateChunks
+		u64 present = 0;          // Buffer swap, or waiting for the GPU when headless
+		u64 render = 0;
+		u64 frame = 0;
+	};
+
 	class Application {
 	public:
 		using ApplicationFunction = std::function<void(Application&)>;
@@ -32,7 +42,12 @@ namespace MC {
 
 		Application& AddAllEventsFunction(const ApplicationEventFunction<IEvent>& fn, const FunctionSettings settings = {});
 
-		Application& CreateWindow(const std::string& title, i32 width, i32 height);
+		Application& CreateWindow(const std::string& title, i32 width, i32 height, WindowMode mode = WindowMode::WINDOWED);
+
+		// Runs the update loop without a window, a renderer or any GL at all. Chunks are still streamed,
+		// generated and meshed, finished meshes only go to a recording sink. Runs until Shutdown
+		Application& CreateHeadless();
+		bool IsHeadless() const;
 		Window& GetWindow() const;
 		Renderer& GetRenderer() const;
 		EventHandler& GetEventHandler() const;
@@ -42,6 +57,8 @@ namespace MC {
 
 		void SetDeltaTime(f32 delta_time);
 
+		const FrameTimings& GetFrameTimings() const;
+
 	private:
 		void RunStartupFunctions();
 		void RunUpdateFunctions();
@@ -70,6 +87,9 @@ namespace MC {
 		std::vector<std::unique_ptr<IQueryEventFunctionWrapper>>                     m_query_event_functions;
 		f32                                                               m_delta_time;
 		std::mutex                                                        m_mutex;
+		FrameTimings                                                      m_frame_timings;
+		bool                                                              m_headless = false;
+		std::atomic<bool>                                                 m_running = true; // Only used when headless
 
 		std::unique_ptr<Scene> m_scene;
 	};
@@ -0,0 +1,355 @@
+#include "benchmark.hpp"
+#include "chunk.hpp"
+#include "chunk_region_grid.hpp"
+#include "chunk_render_table.hpp"
+#include "frustum.hpp"
+#include "log.hpp"
+#include "defines.hpp"
+#include "noise_lattice.hpp"
+#include "thread_pool.hpp"
+
+#include <FastNoise/FastNoise.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <bit>
+#include <vector>
+
+namespace MC {
+    namespace {
+        constexpr i32 BENCHMARK_LOAD_HEIGHT = 4;
+        constexpr i32 BENCHMARK_VIEW_DIRECTIONS = 8;
+        constexpr i32 BENCHMARK_ITERATIONS = 50;
+
+        // Same shape as the set UpdateChunksAroundPlayer keeps loaded
+        std::vector<glm::ivec3> BuildLoadedChunkSet(i32 radius) {
+            std::vector<glm::ivec3> positions;
+            for (i32 x = -radius; x <= radius; ++x) {
+                for (i32 y = -BENCHMARK_LOAD_HEIGHT; y <= BENCHMARK_LOAD_HEIGHT; ++y) {
+                    for (i32 z = -radius; z <= radius; ++z) {
+                        glm::ivec3 offset(x, y, z);
+                        if (glm::length(glm::vec3(offset)) <= radius) {
+                            positions.push_back(offset);
+                        }
+                    }
+                }
+            }
+            return positions;
+        }
+
+        std::vector<Frustum> BuildViewFrustums(f32 far_plane) {
+            std::vector<Frustum> frustums(BENCHMARK_VIEW_DIRECTIONS);
+            glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, far_plane);
+            glm::vec3 eye(8.0f, 8.0f, 8.0f);
+
+            for (i32 i = 0; i < BENCHMARK_VIEW_DIRECTIONS; ++i) {
+                f32 yaw = glm::two_pi<f32>() * i / BENCHMARK_VIEW_DIRECTIONS;
+                glm::vec3 front(std::cos(yaw), -0.2f, std::sin(yaw));
+                frustums[i].Update(projection * glm::lookAt(eye, eye + front, glm::vec3(0.0f, 1.0f, 0.0f)));
+            }
+            return frustums;
+        }
+
+        constexpr i32 NOISE_BENCHMARK_CHUNKS = 64;
+
+        // The fields Scene::GenerateVoxelDataForChunk reads for a chunk with ground and caves,
+        // made of the same Perlin fractals
+        struct NoiseBenchmarkField {
+            FastNoise::SmartNode<FastNoise::FractalFBm> fractal;
+            f32 frequency;
+            i32 size_xz;
+            i32 size_y; // 1 for a 2D field
+        };
+
+        std::vector<NoiseBenchmarkField> BuildNoiseBenchmarkFields() {
+            auto make_fractal = [](i32 octaves) {
+                auto fractal = FastNoise::New<FastNoise::FractalFBm>();
+                fractal->SetSource(FastNoise::New<FastNoise::Perlin>());
+                fractal->SetOctaveCount(octaves);
+                return fractal;
+            };
+
+            std::vector<NoiseBenchmarkField> fields = {
+                { make_fractal(4), 0.012f, 7, 1 }, // Temperature, every 4 blocks
+                { make_fractal(4), 0.012f, 7, 1 }, // Humidity, every 4 blocks
+                { make_fractal(3), 0.2f, 5, 5 },   // Cave lattice, every 4 voxels
+            };
+
+            // Six elevation octaves, each a grid of the same fractal at a higher frequency
+            auto elevation = make_fractal(6);
+            f32 frequency = 0.05f;
+            for (i32 octave = 0; octave < 6; ++octave) {
+                fields.push_back({ elevation, frequency, Chunk::CHUNK_SIZE, 1 });
+                frequency *= 2.2f;
+            }
+            return fields;
+        }
+
+        constexpr i32 CAVE_BENCHMARK_CHUNKS = 256;
+        constexpr f32 CAVE_BENCHMARK_SCALE = 0.05f;     // Same as Scene's cave noise
+        constexpr f32 CAVE_BENCHMARK_THRESHOLD = 0.6f;
+
+        template<typename _Fn>
+        f64 TimePerFrame(_Fn&& cull) {
+            auto start = std::chrono::steady_clock::now();
+            for (i32 i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+                cull();
+            }
+            std::chrono::duration<f64, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() / (BENCHMARK_ITERATIONS * BENCHMARK_VIEW_DIRECTIONS);
+        }
+    }
+
+    void RunCullingBenchmark() {
+        ThreadPool tp;
+        LOG_INFO("Culling benchmark: flat per-chunk frustum test vs. " << ChunkRegionGrid::REGION_SIZE << "^3 chunk regions over the render table, serial and on "
+            << std::thread::hardware_concurrency() << " threads");
+
+        for (i32 radius : { 8, 16, 32, 48, 64 }) {
+            std::vector<glm::ivec3> positions = BuildLoadedChunkSet(radius);
+            std::vector<Frustum> frustums = BuildViewFrustums(static_cast<f32>(radius * Chunk::CHUNK_SIZE));
+
+            ChunkRegionGrid region_grid;
+            ChunkRenderTable render_table;
+            for (const glm::ivec3& chunk_pos : positions) {
+                render_table.Add(chunk_pos, nullptr, region_grid.Add(chunk_pos));
+            }
+            region_grid.UpdateBounds();
+
+            size_t flat_visible = 0;
+            f64 flat_us = TimePerFrame([&]() {
+                for (const Frustum& frustum : frustums) {
+                    for (const glm::ivec3& chunk_pos : positions) {
+                        glm::vec3 chunk_min = glm::vec3(chunk_pos * Chunk::CHUNK_SIZE);
+                        if (frustum.IsBoxVisible(chunk_min, chunk_min + glm::vec3(Chunk::CHUNK_SIZE))) {
+                            ++flat_visible;
+                        }
+                    }
+                }
+                });
+
+            size_t region_count = region_grid.GetRegions().size();
+            std::vector<VisibleChunk> visible;
+            CullingStats stats;
+            f64 region_us = TimePerFrame([&]() {
+                for (const Frustum& frustum : frustums) {
+                    visible.clear();
+                    stats = CullingStats{};
+                    render_table.CullFrustum(frustum, region_grid, 0, region_count, visible, stats);
+                }
+                });
+
+            // Same batching and merge as Renderer::CullChunks
+            size_t batch_count = ThreadPool::GetBatchCount(region_count, ChunkRegionGrid::REGIONS_PER_BATCH);
+            std::vector<std::vector<VisibleChunk>> batch_visible(batch_count);
+            std::vector<CullingStats> batch_stats(batch_count);
+            f64 parallel_us = TimePerFrame([&]() {
+                for (const Frustum& frustum : frustums) {
+                    tp.ParallelFor(region_count, ChunkRegionGrid::REGIONS_PER_BATCH, [&](size_t batch, size_t first_region, size_t last_region) {
+                        batch_visible[batch].clear();
+                        batch_stats[batch] = CullingStats{};
+                        render_table.CullFrustum(frustum, region_grid, first_region, last_region, batch_visible[batch], batch_stats[batch]);
+                        });
+
+                    visible.clear();
+                    for (const std::vector<VisibleChunk>& batch : batch_visible) {
+                        visible.insert(visible.end(), batch.begin(), batch.end());
+                    }
+                }
+                });
+
+            LOG_INFO("radius " << radius << ": " << positions.size() << " chunks, " << stats.chunks_visible << " visible | flat "
+                << flat_us << " us/frame | regions " << region_us << " us/frame (" << stats.regions_tested << " regions, "
+                << stats.regions_inside << " inside, " << stats.regions_culled << " culled, " << stats.chunks_tested << " chunk tests) | "
+                << flat_us / region_us << "x | parallel regions " << parallel_us << " us/frame, " << region_us / parallel_us << "x over serial");
+        }
+    }
+
+    void RunFrustumBenchmark() {
+#if defined(__SIMD_AVX2__)
+        const char* instruction_set = "AVX2";
+#elif defined(__SIMD_SSE2__)
+        const char* instruction_set = "SSE2";
+#else
+        const char* instruction_set = "scalar fallback";
+#endif
+        LOG_INFO("Frustum benchmark: IsBoxVisible vs. TestBoxes (" << instruction_set << ", " << Frustum::BOX_BATCH_SIZE << " boxes per call)");
+
+        for (i32 radius : { 16, 32, 64 }) {
+            std::vector<glm::ivec3> positions = BuildLoadedChunkSet(radius);
+            std::vector<Frustum> frustums = BuildViewFrustums(static_cast<f32>(radius * Chunk::CHUNK_SIZE));
+
+            std::vector<f32> min_x, min_y, min_z, max_x, max_y, max_z;
+            for (const glm::ivec3& chunk_pos : positions) {
+                glm::vec3 chunk_min = glm::vec3(chunk_pos * Chunk::CHUNK_SIZE);
+                min_x.push_back(chunk_min.x);
+                min_y.push_back(chunk_min.y);
+                min_z.push_back(chunk_min.z);
+                max_x.push_back(chunk_min.x + Chunk::CHUNK_SIZE);
+                max_y.push_back(chunk_min.y + Chunk::CHUNK_SIZE);
+                max_z.push_back(chunk_min.z + Chunk::CHUNK_SIZE);
+            }
+            FrustumBoxArrays boxes = { min_x.data(), min_y.data(), min_z.data(), max_x.data(), max_y.data(), max_z.data() };
+            size_t box_count = positions.size();
+
+            size_t scalar_visible = 0;
+            f64 scalar_us = TimePerFrame([&]() {
+                for (const Frustum& frustum : frustums) {
+                    for (size_t i = 0; i < box_count; ++i) {
+                        glm::vec3 box_min(min_x[i], min_y[i], min_z[i]);
+                        glm::vec3 box_max(max_x[i], max_y[i], max_z[i]);
+                        scalar_visible += frustum.IsBoxVisible(box_min, box_max);
+                    }
+                }
+                });
+
+            size_t batched_visible = 0;
+            f64 batched_us = TimePerFrame([&]() {
+                for (const Frustum& frustum : frustums) {
+                    for (size_t i = 0; i < box_count; i += Frustum::BOX_BATCH_SIZE) {
+                        u32 count = static_cast<u32>(std::min<size_t>(box_count - i, Frustum::BOX_BATCH_SIZE));
+                        batched_visible += std::popcount(frustum.TestBoxes(boxes, i, count));
+                    }
+                }
+                });
+
+            if (scalar_visible != batched_visible) {
+                LOG_WARN("radius " << radius << ": batched test disagrees with the scalar one, " << batched_visible << " vs. " << scalar_visible << " visible");
+            }
+
+            LOG_INFO("radius " << radius << ": " << box_count << " boxes | scalar " << box_count / scalar_us << " Mboxes/s | batched "
+                << box_count / batched_us << " Mboxes/s | " << scalar_us / batched_us << "x");
+        }
+    }
+
+    void RunNoiseBenchmark() {
+        LOG_INFO("Noise benchmark: GenSingle per sample vs. one GenUniformGrid call per field, " << NOISE_BENCHMARK_CHUNKS << " chunks");
+
+        std::vector<NoiseBenchmarkField> fields = BuildNoiseBenchmarkFields();
+        std::vector<glm::ivec3> positions;
+        for (i32 i = 0; i < NOISE_BENCHMARK_CHUNKS; ++i) {
+            positions.push_back(glm::ivec3(i % 8, (i / 8) % 2, i / 16) * Chunk::CHUNK_SIZE);
+        }
+
+        size_t samples_per_chunk = 0;
+        for (const NoiseBenchmarkField& field : fields) {
+            samples_per_chunk += static_cast<size_t>(field.size_xz) * field.size_xz * field.size_y;
+        }
+
+        std::vector<f32> single_values;
+        std::vector<f32> grid_values;
+        single_values.reserve(samples_per_chunk * NOISE_BENCHMARK_CHUNKS);
+        grid_values.reserve(samples_per_chunk * NOISE_BENCHMARK_CHUNKS);
+        std::vector<f32> grid(Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE + (Chunk::CHUNK_SIZE + 2) * (Chunk::CHUNK_SIZE + 2));
+        const i32 seed = 1337;
+
+        // Same traversal as the grids, x fastest, then y, then z
+        auto start = std::chrono::steady_clock::now();
+        for (const glm::ivec3& origin : positions) {
+            for (const NoiseBenchmarkField& field : fields) {
+                for (i32 z = 0; z < field.size_xz; ++z) {
+                    for (i32 y = 0; y < field.size_y; ++y) {
+                        for (i32 x = 0; x < field.size_xz; ++x) {
+                            if (field.size_y == 1) {
+                                single_values.push_back(field.fractal->GenSingle2D((origin.x + x) * field.frequency, (origin.z + z) * field.frequency, seed));
+                            }
+                            else {
+                                single_values.push_back(field.fractal->GenSingle3D((origin.x + x) * field.frequency, (origin.y + y) * field.frequency,
+                                    (origin.z + z) * field.frequency, seed));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        std::chrono::duration<f64> single_seconds = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (const glm::ivec3& origin : positions) {
+            for (const NoiseBenchmarkField& field : fields) {
+                size_t count = static_cast<size_t>(field.size_xz) * field.size_xz * field.size_y;
+                if (field.size_y == 1) {
+                    field.fractal->GenUniformGrid2D(grid.data(), origin.x, origin.z, field.size_xz, field.size_xz, field.frequency, seed);
+                }
+                else {
+                    field.fractal->GenUniformGrid3D(grid.data(), origin.x, origin.y, origin.z, field.size_xz, field.size_y, field.size_xz, field.frequency, seed);
+                }
+                grid_values.insert(grid_values.end(), grid.begin(), grid.begin() + count);
+            }
+        }
+        std::chrono::duration<f64> grid_seconds = std::chrono::steady_clock::now() - start;
+
+        f32 max_difference = 0.0f;
+        for (size_t i = 0; i < std::min(single_values.size(), grid_values.size()); ++i) {
+            max_difference = std::max(max_difference, std::abs(single_values[i] - grid_values[i]));
+        }
+        if (single_values.size() != grid_values.size() || max_difference > 1.0e-4f) {
+            LOG_WARN("Grid samples disagree with the single ones, largest difference " << max_difference);
+        }
+
+        LOG_INFO(samples_per_chunk << " samples per chunk | single " << NOISE_BENCHMARK_CHUNKS / single_seconds.count()
+            << " chunks/s | grid " << NOISE_BENCHMARK_CHUNKS / grid_seconds.count() << " chunks/s | "
+            << single_seconds.count() / grid_seconds.count() << "x");
+    }
+
+    void RunCaveBenchmark() {
+        LOG_INFO("Cave benchmark: cave density interpolated from a lattice vs. sampled at every voxel, " << CAVE_BENCHMARK_CHUNKS << " chunks");
+
+        auto fractal = FastNoise::New<FastNoise::FractalFBm>();
+        fractal->SetSource(FastNoise::New<FastNoise::Perlin>());
+        fractal->SetOctaveCount(3);
+        const i32 seed = 1337;
+        const i32 size = Chunk::CHUNK_SIZE;
+        const size_t voxel_count = static_cast<size_t>(size) * size * size;
+
+        std::vector<glm::ivec3> origins;
+        for (i32 i = 0; i < CAVE_BENCHMARK_CHUNKS; ++i) {
+            origins.push_back(glm::ivec3(i % 8, (i / 8) % 4 - 2, i / 32) * size);
+        }
+
+        // Exact density of every chunk as the reference
+        std::vector<f32> exact(voxel_count * origins.size());
+        auto start = std::chrono::steady_clock::now();
+        for (size_t chunk = 0; chunk < origins.size(); ++chunk) {
+            const glm::ivec3& origin = origins[chunk];
+            fractal->GenUniformGrid3D(exact.data() + chunk * voxel_count, origin.x, origin.y, origin.z, size, size, size, CAVE_BENCHMARK_SCALE, seed);
+        }
+        std::chrono::duration<f64> exact_seconds = std::chrono::steady_clock::now() - start;
+
+        size_t exact_caves = 0;
+        for (f32 density : exact) {
+            exact_caves += density > CAVE_BENCHMARK_THRESHOLD;
+        }
+        LOG_INFO("exact: " << CAVE_BENCHMARK_CHUNKS / exact_seconds.count() << " chunks/s, "
+            << 100.0 * exact_caves / exact.size() << "% of voxels are cave");
+
+        std::vector<f32> lattice(static_cast<size_t>(size + 1) * (size + 1) * (size + 1));
+        std::vector<f32> interpolated(voxel_count * origins.size());
+        for (i32 spacing : { 2, 4, 8 }) {
+            i32 samples = GetLatticeSamplesPerAxis(size, spacing);
+
+            start = std::chrono::steady_clock::now();
+            for (size_t chunk = 0; chunk < origins.size(); ++chunk) {
+                const glm::ivec3& origin = origins[chunk];
+                fractal->GenUniformGrid3D(lattice.data(), origin.x / spacing, origin.y / spacing, origin.z / spacing,
+                    samples, samples, samples, CAVE_BENCHMARK_SCALE * spacing, seed);
+                UpsampleLattice3D(lattice.data(), size, spacing, interpolated.data() + chunk * voxel_count);
+            }
+            std::chrono::duration<f64> lattice_seconds = std::chrono::steady_clock::now() - start;
+
+            // A mismatch is a voxel that is cave in one field and solid in the other
+            size_t mismatches = 0;
+            f32 max_difference = 0.0f;
+            for (size_t i = 0; i < exact.size(); ++i) {
+                mismatches += (exact[i] > CAVE_BENCHMARK_THRESHOLD) != (interpolated[i] > CAVE_BENCHMARK_THRESHOLD);
+                max_difference = std::max(max_difference, std::abs(exact[i] - interpolated[i]));
+            }
+
+            LOG_INFO("spacing " << spacing << ": " << samples * samples * samples << " samples per chunk | "
+                << CAVE_BENCHMARK_CHUNKS / lattice_seconds.count() << " chunks/s, " << exact_seconds.count() / lattice_seconds.count()
+                << "x | " << 100.0 * mismatches / exact.size() << "% of voxels mismatch ("
+                << (exact_caves ? 100.0 * mismatches / exact_caves : 0.0) << "% of cave voxels), largest density difference " << max_difference);
+        }
+    }
+}
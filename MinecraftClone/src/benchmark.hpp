@@ -0,0 +1,22 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+namespace MC {
+    // Standalone timing runs selected from the command line, none of them open a window
+
+    // Flat per-chunk frustum tests against region culling over a range of load radii
+    void RunCullingBenchmark();
+
+    // Scalar Frustum::IsBoxVisible against the batched Frustum::TestBoxes, in boxes per second
+    void RunFrustumBenchmark();
+
+    // The noise fields of chunk generation sampled one GenSingle call at a time against one grid call
+    // per field, in chunks per second
+    void RunNoiseBenchmark();
+
+    // Cave density interpolated from lattices of several spacings against the exact per-voxel field, in chunks
+    // per second and the share of voxels whose cave or solid classification changes
+    void RunCaveBenchmark();
+}
+
+#endif // BENCHMARK_HPP
@@ -77,6 +77,16 @@ namespace MC {
         m_fov = glm::clamp(fov, 1.0f, 90.0f);
     }
 
+    void Camera::SetPosition(const glm::vec3& position) {
+        m_position = position;
+    }
+
+    void Camera::SetRotation(f32 yaw, f32 pitch) {
+        m_yaw = yaw;
+        m_pitch = glm::clamp(pitch, -89.0f, 89.0f);
+        UpdateCameraVectors();
+    }
+
     void Camera::ProcessMouseScroll(f32 yoffset) {
         m_fov -= yoffset;
         m_fov = glm::clamp(m_fov, 1.0f, 45.0f);
@@ -35,6 +35,9 @@ namespace MC {
 
         // Accessors
         f32 GetFOV() const { return m_fov; }
+        f32 GetAspectRatio() const { return m_aspect_ratio; }
+        f32 GetNear() const { return m_near; }
+        f32 GetFar() const { return m_far; }
         f32 GetMouseSensitivity() const { return m_mouse_sensitivity; }
         glm::vec3 GetPosition() const { return m_position; }
         glm::vec3 GetFront() const { return m_front; }
@@ -47,6 +50,10 @@ namespace MC {
         void SetAspectRatio(f32 aspect_ratio);
         void SetFOV(f32 fov);
 
+        // Places the camera directly, used by scripted camera paths
+        void SetPosition(const glm::vec3& position);
+        void SetRotation(f32 yaw, f32 pitch);
+
         void SetFar(f32 far);
         void IncreaseFar(f32 amount);
         void DecreaseFar(f32 amount);
@@ -1,8 +1,9 @@
 #include "chunk.hpp"
 
-#include <GL/glew.h>
 #include "scene.hpp"
 
+#include <algorithm>
+
 namespace MC {
     Chunk::Chunk(const glm::ivec3& position)
         : m_position(position), m_needs_mesh_update(true) {
@@ -37,6 +38,20 @@ namespace MC {
         SetVoxel(local_pos, VoxelType::AIR);
     }
 
+    void Chunk::Fill(VoxelType voxel_type) {
+        m_voxel_types.fill(static_cast<u8>(voxel_type));
+        m_needs_mesh_update = true;
+    }
+
+    u64 Chunk::ComputeContentHash() const {
+        u64 hash = 0xcbf29ce484222325ull;
+        for (u8 voxel_type : m_voxel_types) {
+            hash ^= voxel_type;
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
     glm::ivec3 Chunk::GetPosition() const {
         return m_position;
     }
@@ -53,6 +68,22 @@ namespace MC {
         return m_mesh_data_uploaded;
     }
 
+    bool Chunk::IsMeshGenerationPending() const {
+        return m_mesh_generation_future.valid() &&
+            m_mesh_generation_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    }
+
+    void Chunk::WaitForMeshGeneration() const {
+        if (m_mesh_generation_future.valid()) {
+            m_mesh_generation_future.wait();
+        }
+    }
+
+    size_t Chunk::GetPendingUploadBytes() {
+        std::lock_guard<std::mutex> lock(m_mesh_mutex);
+        return m_vertices.size() * sizeof(Vertex) + m_indices.size() * sizeof(u32);
+    }
+
     void Chunk::SetNeedsMeshUpdate(bool needs_update) {
         m_needs_mesh_update = needs_update;
     }
@@ -141,61 +172,115 @@ namespace MC {
             }
         }
 
+        m_face_connectivity = ComputeFaceConnectivity();
+
         m_mesh_data_generated = true;
         m_mesh_data_uploaded = false;
     }
 
+    u16 Chunk::ComputeFaceConnectivity() const {
+        size_t air_count = std::count(m_voxel_types.begin(), m_voxel_types.end(), static_cast<u8>(VoxelType::AIR));
+        if (air_count == 0) {
+            return 0;
+        }
+        if (air_count == TOTAL_VOXELS) {
+            return ALL_FACES_CONNECTED;
+        }
 
-    void Chunk::UploadMeshData() {
-        std::lock_guard<std::mutex> lock(m_mesh_mutex);
+        static constexpr i32 SLICE = CHUNK_SIZE * CHUNK_SIZE;
 
-        if (!m_mesh_data_generated || m_mesh_data_uploaded) {
-            return; // Nothing to upload
-        }
+        std::array<bool, TOTAL_VOXELS> visited{};
+        std::array<u16, TOTAL_VOXELS> stack;
+        u16 connectivity = 0;
 
-        // Generate or update VBOs
-        if (m_vao == 0) {
-            glGenVertexArrays(1, &m_vao);
-            glGenBuffers(1, &m_vbo);
-            glGenBuffers(1, &m_ebo);
-        }
+        for (size_t start = 0; start < TOTAL_VOXELS; ++start) {
+            if (visited[start] || m_voxel_types[start] != static_cast<u8>(VoxelType::AIR)) {
+                continue;
+            }
 
-        glBindVertexArray(m_vao);
+            // Faces touched by this air pocket, indexed like Voxel::FaceIndex
+            u8 faces = 0;
+            size_t top = 0;
+            stack[top++] = static_cast<u16>(start);
+            visited[start] = true;
+
+            while (top > 0) {
+                i32 index = stack[--top];
+                i32 x = index % CHUNK_SIZE;
+                i32 y = (index / CHUNK_SIZE) % CHUNK_SIZE;
+                i32 z = index / SLICE;
+
+                const i32 neighbors[6] = {
+                    x < CHUNK_SIZE - 1 ? index + 1 : -1,          // POS_X
+                    x > 0 ? index - 1 : -1,                       // NEG_X
+                    y < CHUNK_SIZE - 1 ? index + CHUNK_SIZE : -1, // POS_Y
+                    y > 0 ? index - CHUNK_SIZE : -1,              // NEG_Y
+                    z < CHUNK_SIZE - 1 ? index + SLICE : -1,      // POS_Z
+                    z > 0 ? index - SLICE : -1                    // NEG_Z
+                };
+
+                for (i32 face = 0; face < 6; ++face) {
+                    i32 neighbor = neighbors[face];
+                    if (neighbor < 0) {
+                        faces |= 1 << face; // On the chunk boundary
+                        continue;
+                    }
+                    if (!visited[neighbor] && m_voxel_types[neighbor] == static_cast<u8>(VoxelType::AIR)) {
+                        visited[neighbor] = true;
+                        stack[top++] = static_cast<u16>(neighbor);
+                    }
+                }
+            }
 
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vertex), m_vertices.data(), GL_STATIC_DRAW);
+            for (i32 face_a = 0; face_a < 6; ++face_a) {
+                for (i32 face_b = face_a + 1; face_b < 6; ++face_b) {
+                    if ((faces & (1 << face_a)) && (faces & (1 << face_b))) {
+                        connectivity |= GetFacePairMask(face_a, face_b);
+                    }
+                }
+            }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(u32), m_indices.data(), GL_STATIC_DRAW);
+            if (connectivity == ALL_FACES_CONNECTED) {
+                break;
+            }
+        }
 
-        // Vertex attributes
-        glEnableVertexAttribArray(0); // Position
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
+        return connectivity;
+    }
 
-        glEnableVertexAttribArray(1); // Normal
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
 
-        glEnableVertexAttribArray(2); // Color attribute
-        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    void Chunk::UploadMeshData(IChunkMeshSink& sink) {
+        std::lock_guard<std::mutex> lock(m_mesh_mutex);
+
+        if (!m_mesh_data_generated || m_mesh_data_uploaded) {
+            return; // Nothing to upload
+        }
+
+        // Replace the previous mesh range
+        sink.Free(m_mesh_allocation);
+        m_mesh_allocation = sink.Upload(m_vertices, m_indices);
 
-        glBindVertexArray(0);
+        // The sink holds the only copy we need from here on
+        std::vector<Vertex>().swap(m_vertices);
+        std::vector<u32>().swap(m_indices);
 
-        m_needs_mesh_update = false;
         m_mesh_data_uploaded = true;
     }
 
+    void Chunk::ReleaseMeshData(IChunkMeshSink& sink) {
+        std::lock_guard<std::mutex> lock(m_mesh_mutex);
+        sink.Free(m_mesh_allocation);
+        m_mesh_data_uploaded = false;
+    }
+
     void Chunk::Update(const Scene& scene, ThreadPool& tp) {
-        if (NeedsMeshUpdate() && !HasMeshDataGenerated()) {
-            // Enqueue mesh generation
+        // One mesh job per chunk at a time, edits made while it runs schedule another one
+        if (NeedsMeshUpdate() && !IsMeshGenerationPending()) {
+            SetNeedsMeshUpdate(false);
             m_mesh_generation_future = tp.Enqueue(TaskPriority::VERY_HIGH, true, [this, &scene]() {
                     GenerateMeshData(scene);
-                    SetNeedsMeshUpdate(false);
                 });
         }
-        else if (HasMeshDataGenerated() && !IsMeshDataUploaded()) {
-            // Upload mesh data on the main thread
-            UploadMeshData();
-        }
     }
 
 }
@@ -4,17 +4,38 @@
 #include "types.hpp"
 #include "voxel.hpp"
 #include "thread_pool.hpp"
+#include "mesh_arena.hpp"
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <vector>
 
 namespace MC {
     class Scene;
+
+    struct ChunkVisibilityStamp {
+        u32 in_frustum_frame = 0;
+        u32 visited_frame = 0;
+        u32 render_row = 0; // Row in the chunk render table, valid for the frame in in_frustum_frame
+    };
+
     class Chunk {
     public:
         static constexpr i32 CHUNK_SIZE = 16;
         static constexpr size_t TOTAL_VOXELS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
 
+        // One bit per unordered pair of faces (Voxel::FaceIndex), 15 in total
+        static constexpr u16 ALL_FACES_CONNECTED = 0x7FFF;
+
+        static constexpr u16 GetFacePairMask(i32 face_a, i32 face_b) {
+            if (face_a > face_b) {
+                i32 temp = face_a;
+                face_a = face_b;
+                face_b = temp;
+            }
+            return static_cast<u16>(1u << (face_a * (11 - face_a) / 2 + face_b - face_a - 1));
+        }
+
         Chunk(const glm::ivec3& position);
 
         // Voxel operations
@@ -22,6 +43,12 @@ namespace MC {
         VoxelType GetVoxel(const glm::ivec3& local_pos) const;
         void RemoveVoxel(const glm::ivec3& local_pos);
 
+        // Sets every voxel of the chunk at once
+        void Fill(VoxelType voxel_type);
+
+        // FNV-1a over the voxel types, equal for chunks with the same content
+        u64 ComputeContentHash() const;
+
         // Position of the chunk in chunk coordinates
         glm::ivec3 GetPosition() const;
 
@@ -35,17 +62,43 @@ namespace MC {
         bool HasMeshDataGenerated() const;
         bool IsMeshDataUploaded() const;
 
+        // True while a worker is still building this chunk's mesh
+        bool IsMeshGenerationPending() const;
+        void WaitForMeshGeneration() const;
+
+        // Size of the generated mesh waiting to be uploaded
+        size_t GetPendingUploadBytes();
+
         void GenerateMeshData(const Scene& scene);
-        void UploadMeshData();
+        void UploadMeshData(IChunkMeshSink& sink);
 
+        // Returns the chunk's mesh range to the sink's free list
+        void ReleaseMeshData(IChunkMeshSink& sink);
+
+        // Schedules mesh generation, uploads are left to the scene's upload queue
         void Update(const Scene& scene, ThreadPool& tp);
 
-        u32 GetVAO() const {
-            return m_vao;
+        const MeshAllocation& GetMeshAllocation() const {
+            return m_mesh_allocation;
         }
 
         size_t GetIndexCount() const {
-            return m_indices.size();
+            return m_mesh_allocation.index_count;
+        }
+
+        // Whether air connects the two faces inside this chunk, refreshed with every mesh rebuild.
+        // Chunks that were never meshed report every pair as connected
+        bool AreFacesConnected(i32 face_a, i32 face_b) const {
+            return (m_face_connectivity.load(std::memory_order_relaxed) & GetFacePairMask(face_a, face_b)) != 0;
+        }
+
+        u16 GetFaceConnectivity() const {
+            return m_face_connectivity.load(std::memory_order_relaxed);
+        }
+
+        // Frame stamps written by the occlusion culler, only touched from the render thread
+        ChunkVisibilityStamp& GetVisibilityStamp() {
+            return m_visibility_stamp;
         }
 
     private:
@@ -53,14 +106,15 @@ namespace MC {
             return local_pos.x + CHUNK_SIZE * (local_pos.y + CHUNK_SIZE * local_pos.z);
         }
 
+        // Flood fills the air in the chunk and records which faces each air pocket touches
+        u16 ComputeFaceConnectivity() const;
+
     private:
         glm::ivec3 m_position; // Chunk position in chunk coordinates
         std::array<uint8_t, TOTAL_VOXELS> m_voxel_types; // Voxel types in the chunk
 
-        bool m_needs_mesh_update;
-        u32 m_vao = 0;
-        u32 m_vbo = 0;
-        u32 m_ebo = 0;
+        std::atomic<bool> m_needs_mesh_update;
+        MeshAllocation m_mesh_allocation;
         std::vector<Vertex> m_vertices;
         std::vector<u32> m_indices;
 
@@ -68,8 +122,11 @@ namespace MC {
         std::future<void> m_mesh_generation_future;
 
         // Flags to indicate if mesh data needs uploading
-        bool m_mesh_data_generated = false;
-        bool m_mesh_data_uploaded = false;
+        std::atomic<bool> m_mesh_data_generated = false;
+        std::atomic<bool> m_mesh_data_uploaded = false;
+
+        std::atomic<u16> m_face_connectivity = ALL_FACES_CONNECTED;
+        ChunkVisibilityStamp m_visibility_stamp;
     };
 }
 
@@ -0,0 +1,94 @@
+#include "chunk_region_grid.hpp"
+#include "chunk.hpp"
+
+#include <algorithm>
+
+namespace MC {
+    glm::ivec3 ChunkRegionGrid::GetRegionPosition(const glm::ivec3& chunk_pos) {
+        // Floor division so negative chunk coordinates land in the right region
+        return glm::ivec3(glm::floor(glm::vec3(chunk_pos) / static_cast<f32>(REGION_SIZE)));
+    }
+
+    u32 ChunkRegionGrid::Add(const glm::ivec3& chunk_pos) {
+        glm::ivec3 region_pos = GetRegionPosition(chunk_pos);
+        auto index_it = m_region_indices.find(region_pos);
+        if (index_it == m_region_indices.end()) {
+            // Reuse an emptied slot so the indices of the other regions never move
+            u32 region_index = static_cast<u32>(m_regions.size());
+            if (!m_free_regions.empty()) {
+                region_index = m_free_regions.back();
+                m_free_regions.pop_back();
+            }
+            else {
+                m_regions.emplace_back();
+            }
+
+            m_regions[region_index].position = region_pos;
+            index_it = m_region_indices.emplace(region_pos, region_index).first;
+        }
+
+        ChunkRegion& region = m_regions[index_it->second];
+        region.chunk_positions.push_back(chunk_pos);
+        region.bounds_dirty = true;
+        ++m_chunk_count;
+        return index_it->second;
+    }
+
+    void ChunkRegionGrid::Remove(const glm::ivec3& chunk_pos) {
+        auto index_it = m_region_indices.find(GetRegionPosition(chunk_pos));
+        if (index_it == m_region_indices.end()) {
+            return;
+        }
+
+        ChunkRegion& region = m_regions[index_it->second];
+        auto pos_it = std::find(region.chunk_positions.begin(), region.chunk_positions.end(), chunk_pos);
+        if (pos_it == region.chunk_positions.end()) {
+            return;
+        }
+
+        // Swap with the last member, order inside a region does not matter
+        *pos_it = region.chunk_positions.back();
+        region.chunk_positions.pop_back();
+        region.bounds_dirty = true;
+        --m_chunk_count;
+
+        if (region.chunk_positions.empty()) {
+            m_free_regions.push_back(index_it->second);
+            m_region_indices.erase(index_it);
+        }
+    }
+
+    void ChunkRegionGrid::Clear() {
+        m_regions.clear();
+        m_region_indices.clear();
+        m_free_regions.clear();
+        m_chunk_count = 0;
+    }
+
+    void ChunkRegionGrid::UpdateBounds() {
+        for (ChunkRegion& region : m_regions) {
+            if (!region.bounds_dirty || region.chunk_positions.empty()) {
+                continue;
+            }
+
+            glm::ivec3 min_chunk = region.chunk_positions.front();
+            glm::ivec3 max_chunk = min_chunk;
+            for (const glm::ivec3& chunk_pos : region.chunk_positions) {
+                min_chunk = glm::min(min_chunk, chunk_pos);
+                max_chunk = glm::max(max_chunk, chunk_pos);
+            }
+
+            region.min = glm::vec3(min_chunk * Chunk::CHUNK_SIZE);
+            region.max = glm::vec3((max_chunk + 1) * Chunk::CHUNK_SIZE);
+            region.bounds_dirty = false;
+        }
+    }
+
+    const std::vector<ChunkRegion>& ChunkRegionGrid::GetRegions() const {
+        return m_regions;
+    }
+
+    size_t ChunkRegionGrid::GetChunkCount() const {
+        return m_chunk_count;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef CHUNK_REGION_GRID_HPP
+#define CHUNK_REGION_GRID_HPP
+
+#include "types.hpp"
+#include "hash.hpp"
+#include "frustum.hpp"
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace MC {
+    class Chunk;
+
+    struct VisibleChunk {
+        glm::ivec3 position;
+        Chunk* chunk;
+        u32 row; // Row in the chunk render table
+    };
+
+    struct CullingStats {
+        u32 regions_tested = 0;
+        u32 regions_inside = 0;   // Accepted without testing their chunks
+        u32 regions_culled = 0;
+        u32 chunks_tested = 0;
+        u32 chunks_visible = 0;
+        u32 chunks_occluded = 0;  // Inside the frustum but cut off from the camera by solid terrain
+        u32 chunks_below_horizon = 0;
+        u64 cull_microseconds = 0;
+
+        // Adds the counters of a partial result, timings are left alone
+        void Merge(const CullingStats& other) {
+            regions_tested += other.regions_tested;
+            regions_inside += other.regions_inside;
+            regions_culled += other.regions_culled;
+            chunks_tested += other.chunks_tested;
+            chunks_visible += other.chunks_visible;
+            chunks_occluded += other.chunks_occluded;
+            chunks_below_horizon += other.chunks_below_horizon;
+        }
+    };
+
+    // A cube of REGION_SIZE^3 chunk slots, culled as a whole before its chunks are looked at
+    struct ChunkRegion {
+        glm::ivec3 position = glm::ivec3(0);
+
+        // Bounds of the loaded member chunks in world space
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+        bool bounds_dirty = true;
+
+        std::vector<glm::ivec3> chunk_positions;
+    };
+
+    // Coarse spatial index over the loaded chunks, kept in sync by the scene on load and unload
+    class ChunkRegionGrid {
+    public:
+        static constexpr i32 REGION_SIZE = 8;
+
+        // Regions handed to one thread pool task when culling in parallel
+        static constexpr size_t REGIONS_PER_BATCH = 16;
+
+        static glm::ivec3 GetRegionPosition(const glm::ivec3& chunk_pos);
+
+        // Returns the index of the chunk's region, which stays put for as long as the region has members
+        u32 Add(const glm::ivec3& chunk_pos);
+        void Remove(const glm::ivec3& chunk_pos);
+        void Clear();
+
+        // Recomputes the bounds of regions whose membership changed
+        void UpdateBounds();
+
+        // Emptied regions leave their slot behind for the next new region
+        const std::vector<ChunkRegion>& GetRegions() const;
+        size_t GetChunkCount() const;
+
+    private:
+        std::vector<ChunkRegion> m_regions;
+        std::unordered_map<glm::ivec3, u32> m_region_indices;
+        std::vector<u32> m_free_regions;
+        size_t m_chunk_count = 0;
+    };
+}
+
+#endif // CHUNK_REGION_GRID_HPP
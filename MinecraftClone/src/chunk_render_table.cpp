@@ -0,0 +1,209 @@
+#include "chunk_render_table.hpp"
+#include "chunk.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace MC {
+    namespace {
+        template<typename _Fn>
+        void ForEachColumn(ChunkRenderRows& rows, _Fn&& fn) {
+            fn(rows.min_x);
+            fn(rows.min_y);
+            fn(rows.min_z);
+            fn(rows.max_x);
+            fn(rows.max_y);
+            fn(rows.max_z);
+            fn(rows.region);
+            fn(rows.vertex_offset);
+            fn(rows.index_offset);
+            fn(rows.index_count);
+            fn(rows.flags);
+            fn(rows.position);
+            fn(rows.chunk);
+        }
+    }
+
+    void ChunkRenderTable::MoveRow(u32 from, u32 to) {
+        ForEachColumn(m_rows, [from, to](auto& column) {
+            column[to] = column[from];
+            });
+        m_row_indices[m_rows.position[to]] = to;
+    }
+
+    void ChunkRenderTable::Add(const glm::ivec3& chunk_pos, Chunk* chunk, u32 region) {
+        if (m_row_indices.find(chunk_pos) != m_row_indices.end()) {
+            return;
+        }
+
+        u32 row_count = static_cast<u32>(GetSize());
+        if (region >= m_region_first_rows.size()) {
+            m_region_first_rows.resize(region + 1, row_count);
+            m_region_row_counts.resize(region + 1, 0);
+        }
+
+        ForEachColumn(m_rows, [](auto& column) {
+            column.emplace_back();
+            });
+
+        // Walk the free row at the end down to the region, every later region hands its first row
+        // to the slot past its last one
+        for (size_t later = m_region_first_rows.size() - 1; later > region; --later) {
+            u32 first_row = m_region_first_rows[later];
+            if (m_region_row_counts[later] > 0) {
+                MoveRow(first_row, first_row + m_region_row_counts[later]);
+            }
+            m_region_first_rows[later] = first_row + 1;
+        }
+
+        u32 row = m_region_first_rows[region] + m_region_row_counts[region];
+        ++m_region_row_counts[region];
+
+        glm::vec3 chunk_min = glm::vec3(chunk_pos * Chunk::CHUNK_SIZE);
+        glm::vec3 chunk_max = chunk_min + glm::vec3(Chunk::CHUNK_SIZE);
+
+        m_rows.min_x[row] = chunk_min.x;
+        m_rows.min_y[row] = chunk_min.y;
+        m_rows.min_z[row] = chunk_min.z;
+        m_rows.max_x[row] = chunk_max.x;
+        m_rows.max_y[row] = chunk_max.y;
+        m_rows.max_z[row] = chunk_max.z;
+        m_rows.region[row] = region;
+        m_rows.vertex_offset[row] = 0;
+        m_rows.index_offset[row] = 0;
+        m_rows.index_count[row] = 0;
+        m_rows.flags[row] = 0;
+        m_rows.position[row] = chunk_pos;
+        m_rows.chunk[row] = chunk;
+        m_row_indices[chunk_pos] = row;
+        ++m_layout_version;
+    }
+
+    void ChunkRenderTable::Remove(const glm::ivec3& chunk_pos) {
+        auto index_it = m_row_indices.find(chunk_pos);
+        if (index_it == m_row_indices.end()) {
+            return;
+        }
+
+        u32 row = index_it->second;
+        u32 region = m_rows.region[row];
+        m_row_indices.erase(index_it);
+
+        // Fill the hole with the region's last row, order inside a region does not matter
+        u32 last_row = m_region_first_rows[region] + m_region_row_counts[region] - 1;
+        if (row != last_row) {
+            MoveRow(last_row, row);
+        }
+        --m_region_row_counts[region];
+
+        // Then walk the hole up to the end, every later region moves its last row in front of its first
+        for (size_t later = region + 1; later < m_region_first_rows.size(); ++later) {
+            u32 first_row = m_region_first_rows[later];
+            if (m_region_row_counts[later] > 0) {
+                MoveRow(first_row + m_region_row_counts[later] - 1, first_row - 1);
+            }
+            m_region_first_rows[later] = first_row - 1;
+        }
+
+        ForEachColumn(m_rows, [](auto& column) {
+            column.pop_back();
+            });
+        ++m_layout_version;
+    }
+
+    void ChunkRenderTable::Clear() {
+        m_rows = ChunkRenderRows{};
+        m_row_indices.clear();
+        m_region_first_rows.clear();
+        m_region_row_counts.clear();
+        ++m_layout_version;
+    }
+
+    void ChunkRenderTable::SetMesh(const glm::ivec3& chunk_pos, const MeshAllocation& mesh) {
+        auto index_it = m_row_indices.find(chunk_pos);
+        if (index_it == m_row_indices.end()) {
+            return;
+        }
+
+        u32 row = index_it->second;
+        m_rows.vertex_offset[row] = mesh.vertex_offset;
+        m_rows.index_offset[row] = mesh.index_offset;
+        m_rows.index_count[row] = mesh.index_count;
+        if (mesh.IsValid()) {
+            m_rows.flags[row] |= FLAG_HAS_MESH;
+        }
+        else {
+            m_rows.flags[row] &= static_cast<u8>(~FLAG_HAS_MESH);
+        }
+        ++m_mesh_version;
+    }
+
+    void ChunkRenderTable::CullFrustum(const Frustum& frustum, const ChunkRegionGrid& region_grid, size_t first_region, size_t last_region,
+        std::vector<VisibleChunk>& visible, CullingStats& stats) const {
+        const std::vector<ChunkRegion>& regions = region_grid.GetRegions();
+        FrustumBoxArrays boxes = {
+            m_rows.min_x.data(), m_rows.min_y.data(), m_rows.min_z.data(),
+            m_rows.max_x.data(), m_rows.max_y.data(), m_rows.max_z.data()
+        };
+        size_t first_visible = visible.size();
+        last_region = std::min(last_region, m_region_first_rows.size());
+
+        for (size_t region_index = first_region; region_index < last_region; ++region_index) {
+            u32 first_row = m_region_first_rows[region_index];
+            u32 end_row = first_row + m_region_row_counts[region_index];
+            if (first_row == end_row) {
+                continue; // Emptied slot
+            }
+
+            const ChunkRegion& region = regions[region_index];
+            ++stats.regions_tested;
+
+            u8 straddled_planes;
+            FrustumTest region_test = frustum.ClassifyBox(region.min, region.max, straddled_planes);
+            if (region_test == FrustumTest::OUTSIDE) {
+                ++stats.regions_culled;
+                continue;
+            }
+
+            if (region_test == FrustumTest::INSIDE) {
+                ++stats.regions_inside;
+                for (u32 row = first_row; row < end_row; ++row) {
+                    visible.push_back({ m_rows.position[row], m_rows.chunk[row], row });
+                }
+                continue;
+            }
+
+            // Partially visible region, its rows are tested a batch at a time and only against the
+            // planes the region straddles
+            for (u32 batch_row = first_row; batch_row < end_row; batch_row += Frustum::BOX_BATCH_SIZE) {
+                u32 count = std::min(end_row - batch_row, Frustum::BOX_BATCH_SIZE);
+                stats.chunks_tested += count;
+
+                u32 batch_visible = frustum.TestBoxes(boxes, batch_row, count, straddled_planes);
+                while (batch_visible != 0) {
+                    u32 row = batch_row + static_cast<u32>(std::countr_zero(batch_visible));
+                    batch_visible &= batch_visible - 1;
+                    visible.push_back({ m_rows.position[row], m_rows.chunk[row], row });
+                }
+            }
+        }
+
+        stats.chunks_visible += static_cast<u32>(visible.size() - first_visible);
+    }
+
+    const ChunkRenderRows& ChunkRenderTable::GetRows() const {
+        return m_rows;
+    }
+
+    size_t ChunkRenderTable::GetSize() const {
+        return m_rows.position.size();
+    }
+
+    u64 ChunkRenderTable::GetLayoutVersion() const {
+        return m_layout_version;
+    }
+
+    u64 ChunkRenderTable::GetMeshVersion() const {
+        return m_mesh_version;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef CHUNK_RENDER_TABLE_HPP
+#define CHUNK_RENDER_TABLE_HPP
+
+#include "types.hpp"
+#include "hash.hpp"
+#include "frustum.hpp"
+#include "mesh_arena.hpp"
+#include "chunk_region_grid.hpp"
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace MC {
+    class Chunk;
+
+    // One row per loaded chunk, every field in its own array so a pass only pulls in what it reads
+    struct ChunkRenderRows {
+        // World space bounds
+        std::vector<f32> min_x;
+        std::vector<f32> min_y;
+        std::vector<f32> min_z;
+        std::vector<f32> max_x;
+        std::vector<f32> max_y;
+        std::vector<f32> max_z;
+
+        // Index of the chunk's region in the region grid
+        std::vector<u32> region;
+
+        // Mesh range in the arena, last uploaded version
+        std::vector<u32> vertex_offset;
+        std::vector<u32> index_offset;
+        std::vector<u32> index_count;
+
+        std::vector<u8> flags;
+        std::vector<glm::ivec3> position;
+        std::vector<Chunk*> chunk;
+    };
+
+    // Dense table of the render state of the loaded chunks, kept in sync by the scene on load,
+    // unload and mesh upload so culling and draw building never have to chase chunk pointers.
+    // Rows are grouped by region in region index order, so a region is one contiguous row range
+    class ChunkRenderTable {
+    public:
+        // Set while the row has a non-empty mesh in the arena
+        static constexpr u8 FLAG_HAS_MESH = 1 << 0;
+
+        // Adding and removing rows shifts one row of every later region to keep the ranges packed,
+        // so row indices are only stable between loads and unloads
+        void Add(const glm::ivec3& chunk_pos, Chunk* chunk, u32 region);
+        void Remove(const glm::ivec3& chunk_pos);
+        void Clear();
+
+        // Called after the chunk's mesh went up to the arena
+        void SetMesh(const glm::ivec3& chunk_pos, const MeshAllocation& mesh);
+
+        // Appends the rows of the regions in [first_region, last_region) that are inside the frustum.
+        // Regions are accepted or rejected whole and only the ones straddling a plane have their rows
+        // tested. Safe to run on several threads at once
+        void CullFrustum(const Frustum& frustum, const ChunkRegionGrid& region_grid, size_t first_region, size_t last_region,
+            std::vector<VisibleChunk>& visible, CullingStats& stats) const;
+
+        const ChunkRenderRows& GetRows() const;
+        size_t GetSize() const;
+
+        // Bumped whenever rows are added or removed, and whenever a mesh range changes
+        u64 GetLayoutVersion() const;
+        u64 GetMeshVersion() const;
+
+    private:
+        void MoveRow(u32 from, u32 to);
+
+        ChunkRenderRows m_rows;
+        std::unordered_map<glm::ivec3, u32> m_row_indices;
+
+        // Row range of each region, indexed like ChunkRegionGrid::GetRegions
+        std::vector<u32> m_region_first_rows;
+        std::vector<u32> m_region_row_counts;
+
+        u64 m_layout_version = 0;
+        u64 m_mesh_version = 0;
+    };
+}
+
+#endif // CHUNK_RENDER_TABLE_HPP
@@ -15,6 +15,25 @@
 #	define __WARN__
 #	define __ERROR__
 #	define __FATAL__
+
+// Counts and shadow state on every GL call, Debug only unless the build opts in with premake's --gl-trace
+#	if !defined(NDEBUG) || defined(GL_TRACE)
+#		define __GL_TRACE__
+#	endif
+
+// Timers and atomics on every generated chunk, Debug only unless the build opts in with premake's --worldgen-profile
+#	if !defined(NDEBUG) || defined(WORLDGEN_PROFILE)
+#		define __WORLDGEN_PROFILE__
+#	endif
+#endif
+
+// Instruction sets the hot loops may use, MSVC only tells about AVX2 through /arch
+#if defined(__AVX2__)
+#	define __SIMD_AVX2__
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define __SIMD_SSE2__
 #endif
 
 #define assert_false assert(false)
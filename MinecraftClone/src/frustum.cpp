@@ -1,7 +1,14 @@
 #include "frustum.hpp"
 #include "types.hpp"
+#include "defines.hpp"
 #include <array>
 
+#if defined(__SIMD_AVX2__)
+#include <immintrin.h>
+#elif defined(__SIMD_SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace MC {
     void Frustum::Update(const glm::mat4& view_proj) {
         // Left plane
@@ -80,4 +87,137 @@ namespace MC {
         }
         return true; // Inside or intersecting the frustum
     }
+
+    FrustumTest Frustum::ClassifyBox(const glm::vec3& min, const glm::vec3& max) const {
+        u8 straddled_planes;
+        return ClassifyBox(min, max, straddled_planes);
+    }
+
+    FrustumTest Frustum::ClassifyBox(const glm::vec3& min, const glm::vec3& max, u8& straddled_planes) const {
+        straddled_planes = 0;
+
+        for (i32 i = 0; i < 6; ++i) {
+            const glm::vec4& plane = m_planes[i];
+
+            glm::vec3 positive_vertex = min;
+            glm::vec3 negative_vertex = max;
+
+            if (plane.x >= 0) {
+                positive_vertex.x = max.x;
+                negative_vertex.x = min.x;
+            }
+            if (plane.y >= 0) {
+                positive_vertex.y = max.y;
+                negative_vertex.y = min.y;
+            }
+            if (plane.z >= 0) {
+                positive_vertex.z = max.z;
+                negative_vertex.z = min.z;
+            }
+
+            if (glm::dot(glm::vec3(plane), positive_vertex) + plane.w < 0) {
+                return FrustumTest::OUTSIDE;
+            }
+            if (glm::dot(glm::vec3(plane), negative_vertex) + plane.w < 0) {
+                straddled_planes |= static_cast<u8>(1 << i);
+            }
+        }
+        return straddled_planes != 0 ? FrustumTest::INTERSECTS : FrustumTest::INSIDE;
+    }
+
+    u32 Frustum::TestBoxes(const FrustumBoxArrays& boxes, size_t first, u32 count, u8 plane_mask) const {
+        u32 all_boxes = (1u << count) - 1;
+        if (count == 0 || plane_mask == 0) {
+            return all_boxes;
+        }
+
+        // Min corner in 0-2, max corner in 3-5
+        const f32* coords[6] = {
+            boxes.min_x + first, boxes.min_y + first, boxes.min_z + first,
+            boxes.max_x + first, boxes.max_y + first, boxes.max_z + first
+        };
+
+        // Pad a partial batch so the vector loads never read past the arrays
+        alignas(32) f32 padded[6][BOX_BATCH_SIZE];
+        if (count < BOX_BATCH_SIZE) {
+            for (i32 axis = 0; axis < 6; ++axis) {
+                for (u32 i = 0; i < BOX_BATCH_SIZE; ++i) {
+                    padded[axis][i] = i < count ? coords[axis][i] : 0.0f;
+                }
+                coords[axis] = padded[axis];
+            }
+        }
+
+        // Same test as IsBoxVisible. The corner furthest along a plane's normal is picked by the sign
+        // of the normal alone, so one pick serves every box in the batch
+#if defined(__SIMD_AVX2__)
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (i32 i = 0; i < 6; ++i) {
+            if (!(plane_mask & (1 << i))) {
+                continue;
+            }
+
+            const glm::vec4& plane = m_planes[i];
+            __m256 x = _mm256_loadu_ps(coords[plane.x >= 0 ? 3 : 0]);
+            __m256 y = _mm256_loadu_ps(coords[plane.y >= 0 ? 4 : 1]);
+            __m256 z = _mm256_loadu_ps(coords[plane.z >= 0 ? 5 : 2]);
+
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(z, _mm256_set1_ps(plane.z)));
+            distance = _mm256_add_ps(distance, _mm256_set1_ps(plane.w));
+
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+            if (_mm256_movemask_ps(visible) == 0) {
+                break; // Every box already rejected
+            }
+        }
+        return static_cast<u32>(_mm256_movemask_ps(visible)) & all_boxes;
+#elif defined(__SIMD_SSE2__)
+        u32 result = 0;
+        for (u32 half = 0; half < BOX_BATCH_SIZE; half += 4) {
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (i32 i = 0; i < 6; ++i) {
+                if (!(plane_mask & (1 << i))) {
+                    continue;
+                }
+
+                const glm::vec4& plane = m_planes[i];
+                __m128 x = _mm_loadu_ps(coords[plane.x >= 0 ? 3 : 0] + half);
+                __m128 y = _mm_loadu_ps(coords[plane.y >= 0 ? 4 : 1] + half);
+                __m128 z = _mm_loadu_ps(coords[plane.z >= 0 ? 5 : 2] + half);
+
+                __m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+                distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+                if (_mm_movemask_ps(visible) == 0) {
+                    break;
+                }
+            }
+            result |= static_cast<u32>(_mm_movemask_ps(visible)) << half;
+        }
+        return result & all_boxes;
+#else
+        u32 result = 0;
+        for (u32 box = 0; box < count; ++box) {
+            bool visible = true;
+            for (i32 i = 0; i < 6 && visible; ++i) {
+                if (!(plane_mask & (1 << i))) {
+                    continue;
+                }
+
+                const glm::vec4& plane = m_planes[i];
+                f32 x = coords[plane.x >= 0 ? 3 : 0][box];
+                f32 y = coords[plane.y >= 0 ? 4 : 1][box];
+                f32 z = coords[plane.z >= 0 ? 5 : 2][box];
+                visible = x * plane.x + y * plane.y + z * plane.z + plane.w >= 0;
+            }
+            if (visible) {
+                result |= 1u << box;
+            }
+        }
+        return result;
+#endif
+    }
 }
@@ -1,17 +1,51 @@
 #ifndef FRUSTUM_HPP
 #define FRUSTUM_HPP
 
+#include "types.hpp"
 #include <glm/glm.hpp>
 
 namespace MC {
+    enum class FrustumTest {
+        OUTSIDE,
+        INTERSECTS,
+        INSIDE
+    };
+
+    // Boxes as separate coordinate arrays, the layout of ChunkRenderRows
+    struct FrustumBoxArrays {
+        const f32* min_x;
+        const f32* min_y;
+        const f32* min_z;
+        const f32* max_x;
+        const f32* max_y;
+        const f32* max_z;
+    };
+
     class Frustum {
     public:
+        // Boxes tested per TestBoxes call, one AVX2 register or two SSE registers
+        static constexpr u32 BOX_BATCH_SIZE = 8;
+
+        // One bit per plane in the order of m_planes
+        static constexpr u8 ALL_PLANES = 0x3F;
+
         // Update the frustum planes based on the view-projection matrix
         void Update(const glm::mat4& view_proj);
 
         // Check if a bounding box is visible within the frustum
         bool IsBoxVisible(const glm::vec3& min, const glm::vec3& max) const;
 
+        // Like IsBoxVisible but also tells apart boxes that are entirely inside
+        FrustumTest ClassifyBox(const glm::vec3& min, const glm::vec3& max) const;
+
+        // Also reports the planes the box straddles. Anything inside the box only needs testing
+        // against those, the others it is entirely in front of
+        FrustumTest ClassifyBox(const glm::vec3& min, const glm::vec3& max, u8& straddled_planes) const;
+
+        // Tests boxes [first, first + count) against the planes in plane_mask, count is at most
+        // BOX_BATCH_SIZE. Bit i of the result is set when box first + i is visible
+        u32 TestBoxes(const FrustumBoxArrays& boxes, size_t first, u32 count, u8 plane_mask = ALL_PLANES) const;
+
     private:
         // Frustum planes: left, right, bottom, top, near, far
         glm::vec4 m_planes[6];
@@ -0,0 +1,121 @@
+#include "gl_resource_manager.hpp"
+#include "gl_trace.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+
+namespace MC {
+    GLResourceManager::~GLResourceManager() {
+        for (const PendingRelease& pending : m_pending) {
+            if (pending.buffer.IsValid()) {
+                DeleteBuffer(pending.buffer);
+            }
+            if (pending.vao != 0) {
+                GL::DeleteVertexArray(pending.vao);
+            }
+        }
+
+        for (auto& [size_class, buffers] : m_pool) {
+            for (u32 id : buffers) {
+                DeleteBuffer({ id, size_class });
+            }
+        }
+    }
+
+    size_t GLResourceManager::GetSizeClass(size_t size) {
+        size_t size_class = MIN_BUFFER_SIZE;
+        while (size_class < size) {
+            size_class <<= 1;
+        }
+        return size_class;
+    }
+
+    GLBuffer GLResourceManager::AcquireBuffer(size_t min_size) {
+        GLBuffer buffer;
+        buffer.size = GetSizeClass(min_size);
+
+        auto pool_it = m_pool.find(buffer.size);
+        if (pool_it != m_pool.end() && !pool_it->second.empty()) {
+            buffer.id = pool_it->second.back();
+            pool_it->second.pop_back();
+
+            --m_stats.pooled_buffers;
+            m_stats.pooled_buffer_bytes -= buffer.size;
+            return buffer;
+        }
+
+        // The copy target is bindable regardless of VAO state
+        glGenBuffers(1, &buffer.id);
+        GL::BindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+        GL::BufferData(GL_COPY_WRITE_BUFFER, buffer.size, nullptr, GL_DYNAMIC_DRAW);
+        GL::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        ++m_stats.live_buffers;
+        m_stats.live_buffer_bytes += buffer.size;
+        return buffer;
+    }
+
+    void GLResourceManager::ReleaseBuffer(GLBuffer& buffer) {
+        if (!buffer.IsValid()) {
+            return;
+        }
+
+        m_pending.push_back({ m_frame, buffer, 0 });
+        ++m_stats.pending_releases;
+        buffer = GLBuffer{};
+    }
+
+    u32 GLResourceManager::CreateVertexArray() {
+        u32 vao = 0;
+        glGenVertexArrays(1, &vao);
+        ++m_stats.live_vertex_arrays;
+        return vao;
+    }
+
+    void GLResourceManager::ReleaseVertexArray(u32& vao) {
+        if (vao == 0) {
+            return;
+        }
+
+        m_pending.push_back({ m_frame, GLBuffer{}, vao });
+        ++m_stats.pending_releases;
+        vao = 0;
+    }
+
+    void GLResourceManager::CollectGarbage() {
+        ++m_frame;
+
+        auto first_kept = std::partition(m_pending.begin(), m_pending.end(), [this](const PendingRelease& pending) {
+            return m_frame - pending.frame >= FRAMES_IN_FLIGHT;
+            });
+
+        for (auto it = m_pending.begin(); it != first_kept; ++it) {
+            if (it->vao != 0) {
+                // Vertex arrays carry attribute state, they are not worth recycling
+                GL::DeleteVertexArray(it->vao);
+                --m_stats.live_vertex_arrays;
+            }
+            else if (m_stats.pooled_buffer_bytes + it->buffer.size <= MAX_POOLED_BYTES) {
+                m_pool[it->buffer.size].push_back(it->buffer.id);
+                ++m_stats.pooled_buffers;
+                m_stats.pooled_buffer_bytes += it->buffer.size;
+            }
+            else {
+                DeleteBuffer(it->buffer);
+            }
+            --m_stats.pending_releases;
+        }
+
+        m_pending.erase(m_pending.begin(), first_kept);
+    }
+
+    const GLResourceStats& GLResourceManager::GetStats() const {
+        return m_stats;
+    }
+
+    void GLResourceManager::DeleteBuffer(const GLBuffer& buffer) {
+        GL::DeleteBuffer(buffer.id);
+        --m_stats.live_buffers;
+        m_stats.live_buffer_bytes -= buffer.size;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef GL_RESOURCE_MANAGER_HPP
+#define GL_RESOURCE_MANAGER_HPP
+
+#include "types.hpp"
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace MC {
+    struct GLBuffer {
+        u32 id = 0;
+        size_t size = 0; // Allocated size in bytes, always a whole size class
+
+        bool IsValid() const { return id != 0; }
+    };
+
+    struct GLResourceStats {
+        u32 live_buffers = 0;        // Every buffer object that exists, pooled and pending ones included
+        u32 live_vertex_arrays = 0;
+        size_t live_buffer_bytes = 0;
+        u32 pooled_buffers = 0;      // Idle buffers ready to be handed out again
+        size_t pooled_buffer_bytes = 0;
+        u32 pending_releases = 0;    // Released objects the GPU may still be reading from
+    };
+
+    // Owns buffer and vertex array objects. Buffers are recycled by power of two size class and
+    // released objects are only reused or deleted a few frames later, from the main thread
+    class GLResourceManager {
+    public:
+        static constexpr size_t MIN_BUFFER_SIZE = 64 * 1024;
+        static constexpr size_t MAX_POOLED_BYTES = 64 * 1024 * 1024;
+        static constexpr u64 FRAMES_IN_FLIGHT = 3;
+
+        GLResourceManager() = default;
+        ~GLResourceManager();
+        GLResourceManager(const GLResourceManager&) = delete;
+        GLResourceManager& operator=(const GLResourceManager&) = delete;
+
+        // Returns a buffer of at least min_size bytes with undefined contents
+        GLBuffer AcquireBuffer(size_t min_size);
+        void ReleaseBuffer(GLBuffer& buffer);
+
+        u32 CreateVertexArray();
+        void ReleaseVertexArray(u32& vao);
+
+        // Call once per frame on the thread owning the context
+        void CollectGarbage();
+
+        const GLResourceStats& GetStats() const;
+
+    private:
+        static size_t GetSizeClass(size_t size);
+        void DeleteBuffer(const GLBuffer& buffer);
+
+    private:
+        struct PendingRelease {
+            u64 frame;
+            GLBuffer buffer;
+            u32 vao;
+        };
+
+        // Idle buffers keyed by size class
+        std::map<size_t, std::vector<u32>> m_pool;
+        std::vector<PendingRelease> m_pending;
+        u64 m_frame = 0;
+        GLResourceStats m_stats;
+    };
+}
+
+#endif // GL_RESOURCE_MANAGER_HPP
@@ -0,0 +1,248 @@
+#include "gl_trace.hpp"
+#include "defines.hpp"
+#include "log.hpp"
+#include <GL/glew.h>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace MC {
+    namespace {
+        struct TraceState {
+            GLFrameStats current;
+            GLFrameStats last;
+
+            // What the wrappers last bound, 0 when unknown or unbound
+            u32 bound_vao = 0;
+            u32 bound_program = 0;
+            std::unordered_map<u32, u32> bound_buffers;   // By target
+            std::unordered_map<u32, u32> element_buffers; // By VAO, the element binding is VAO state
+
+            // Captures may be started and stopped from event handlers on other threads
+            std::mutex capture_mutex;
+            std::ofstream capture;
+        };
+
+        TraceState& GetTraceState() {
+            static TraceState state;
+            return state;
+        }
+
+        void CountUpload(size_t size) {
+#ifdef __GL_TRACE__
+            GLFrameStats& stats = GetTraceState().current;
+            ++stats.buffer_uploads;
+            stats.upload_bytes += size;
+#endif
+        }
+
+        void CountDraw(u32 mode, u32 commands, u64 indices) {
+#ifdef __GL_TRACE__
+            GLFrameStats& stats = GetTraceState().current;
+            ++stats.draw_calls;
+            stats.draw_commands += commands;
+            if (mode == GL_TRIANGLES) {
+                stats.triangles += indices / 3;
+            }
+#endif
+        }
+
+        void CountUniformUpdate() {
+#ifdef __GL_TRACE__
+            ++GetTraceState().current.uniform_updates;
+#endif
+        }
+    }
+
+    namespace GL {
+        void BindVertexArray(u32 vao) {
+#ifdef __GL_TRACE__
+            TraceState& state = GetTraceState();
+            ++state.current.vao_binds;
+            if (state.bound_vao == vao) {
+                ++state.current.redundant_vao_binds;
+            }
+            state.bound_vao = vao;
+#endif
+            glBindVertexArray(vao);
+        }
+
+        void BindBuffer(u32 target, u32 buffer) {
+#ifdef __GL_TRACE__
+            TraceState& state = GetTraceState();
+            u32& bound = target == GL_ELEMENT_ARRAY_BUFFER ? state.element_buffers[state.bound_vao] : state.bound_buffers[target];
+            ++state.current.buffer_binds;
+            if (bound == buffer) {
+                ++state.current.redundant_buffer_binds;
+            }
+            bound = buffer;
+#endif
+            glBindBuffer(target, buffer);
+        }
+
+        void BindBufferBase(u32 target, u32 index, u32 buffer) {
+#ifdef __GL_TRACE__
+            // Also binds the generic target, the indexed binding itself is not tracked
+            TraceState& state = GetTraceState();
+            ++state.current.buffer_binds;
+            state.bound_buffers[target] = buffer;
+#endif
+            glBindBufferBase(target, index, buffer);
+        }
+
+        void UseProgram(u32 program) {
+#ifdef __GL_TRACE__
+            TraceState& state = GetTraceState();
+            ++state.current.program_binds;
+            if (state.bound_program == program) {
+                ++state.current.redundant_program_binds;
+            }
+            state.bound_program = program;
+#endif
+            glUseProgram(program);
+        }
+
+        void BufferData(u32 target, size_t size, const void* data, u32 usage) {
+            CountUpload(data ? size : 0);
+            glBufferData(target, size, data, usage);
+        }
+
+        void BufferSubData(u32 target, size_t offset, size_t size, const void* data) {
+            CountUpload(size);
+            glBufferSubData(target, offset, size, data);
+        }
+
+        void DrawElements(u32 mode, i32 count, u32 type, const void* indices) {
+            CountDraw(mode, 1, static_cast<u64>(count));
+            glDrawElements(mode, count, type, indices);
+        }
+
+        void MultiDrawElementsIndirect(u32 mode, u32 type, const void* indirect, i32 draw_count, i32 stride, u64 total_indices) {
+            CountDraw(mode, static_cast<u32>(draw_count), total_indices);
+            glMultiDrawElementsIndirect(mode, type, indirect, draw_count, stride);
+        }
+
+        void Uniform1i(i32 location, i32 value) {
+            CountUniformUpdate();
+            glUniform1i(location, value);
+        }
+
+        void Uniform1f(i32 location, f32 value) {
+            CountUniformUpdate();
+            glUniform1f(location, value);
+        }
+
+        void Uniform3fv(i32 location, const f32* value) {
+            CountUniformUpdate();
+            glUniform3fv(location, 1, value);
+        }
+
+        void Uniform4fv(i32 location, const f32* value) {
+            CountUniformUpdate();
+            glUniform4fv(location, 1, value);
+        }
+
+        void UniformMatrix4fv(i32 location, const f32* value) {
+            CountUniformUpdate();
+            glUniformMatrix4fv(location, 1, GL_FALSE, value);
+        }
+
+        void DeleteBuffer(u32 buffer) {
+#ifdef __GL_TRACE__
+            TraceState& state = GetTraceState();
+            for (auto& [target, bound] : state.bound_buffers) {
+                if (bound == buffer) {
+                    bound = 0;
+                }
+            }
+            for (auto& [vao, bound] : state.element_buffers) {
+                if (bound == buffer) {
+                    bound = 0;
+                }
+            }
+#endif
+            glDeleteBuffers(1, &buffer);
+        }
+
+        void DeleteVertexArray(u32 vao) {
+#ifdef __GL_TRACE__
+            TraceState& state = GetTraceState();
+            if (state.bound_vao == vao) {
+                state.bound_vao = 0;
+            }
+            state.element_buffers.erase(vao);
+#endif
+            glDeleteVertexArrays(1, &vao);
+        }
+
+        void DeleteProgram(u32 program) {
+#ifdef __GL_TRACE__
+            TraceState& state = GetTraceState();
+            if (state.bound_program == program) {
+                state.bound_program = 0;
+            }
+#endif
+            glDeleteProgram(program);
+        }
+    }
+
+    void GLTrace::EndFrame() {
+#ifdef __GL_TRACE__
+        TraceState& state = GetTraceState();
+        state.last = state.current;
+
+        std::lock_guard<std::mutex> lock(state.capture_mutex);
+        if (state.capture.is_open()) {
+            const GLFrameStats& stats = state.last;
+            state.capture << stats.frame << ',' << stats.draw_calls << ',' << stats.draw_commands << ',' << stats.triangles << ','
+                << stats.buffer_uploads << ',' << stats.upload_bytes << ',' << stats.vao_binds << ',' << stats.redundant_vao_binds << ','
+                << stats.buffer_binds << ',' << stats.redundant_buffer_binds << ',' << stats.program_binds << ','
+                << stats.redundant_program_binds << ',' << stats.uniform_updates << '\n';
+        }
+
+        u64 next_frame = state.current.frame + 1;
+        state.current = GLFrameStats{};
+        state.current.frame = next_frame;
+#endif
+    }
+
+    const GLFrameStats& GLTrace::GetLastFrameStats() {
+        return GetTraceState().last;
+    }
+
+    bool GLTrace::StartCapture(const std::string& path) {
+#ifdef __GL_TRACE__
+        TraceState& state = GetTraceState();
+        std::lock_guard<std::mutex> lock(state.capture_mutex);
+        state.capture.close();
+        state.capture.open(path, std::ios::out | std::ios::trunc);
+        if (!state.capture.is_open()) {
+            LOG_ERROR("Failed to open GL trace capture file: " << path);
+            return false;
+        }
+
+        state.capture << "frame,draw_calls,draw_commands,triangles,buffer_uploads,upload_bytes,vao_binds,redundant_vao_binds,"
+            "buffer_binds,redundant_buffer_binds,program_binds,redundant_program_binds,uniform_updates\n";
+        LOG_INFO("Capturing GL frame stats to " << path);
+        return true;
+#else
+        LOG_WARN("GL tracing is not compiled into this build, nothing to capture");
+        return false;
+#endif
+    }
+
+    void GLTrace::StopCapture() {
+        TraceState& state = GetTraceState();
+        std::lock_guard<std::mutex> lock(state.capture_mutex);
+        if (state.capture.is_open()) {
+            state.capture.close();
+            LOG_INFO("GL frame stats capture stopped");
+        }
+    }
+
+    bool GLTrace::IsCapturing() {
+        TraceState& state = GetTraceState();
+        std::lock_guard<std::mutex> lock(state.capture_mutex);
+        return state.capture.is_open();
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef GL_TRACE_HPP
+#define GL_TRACE_HPP
+
+#include "types.hpp"
+#include <string>
+
+namespace MC {
+    // What went through the GL wrappers during one frame
+    struct GLFrameStats {
+        u64 frame = 0;
+        u32 draw_calls = 0;
+        u32 draw_commands = 0;     // Individual draws, a multi-draw counts every command
+        u64 triangles = 0;
+        u32 buffer_uploads = 0;
+        u64 upload_bytes = 0;
+        u32 vao_binds = 0;
+        u32 redundant_vao_binds = 0;
+        u32 buffer_binds = 0;
+        u32 redundant_buffer_binds = 0;
+        u32 program_binds = 0;
+        u32 redundant_program_binds = 0;
+        u32 uniform_updates = 0;
+    };
+
+    // Wrappers for the GL calls the game issues every frame. Built with __GL_TRACE__ they count what
+    // passes through them and flag binds of objects that are already bound, otherwise they only forward.
+    // Binds must all go through here or the bound state they compare against drifts
+    namespace GL {
+        void BindVertexArray(u32 vao);
+        void BindBuffer(u32 target, u32 buffer);
+        void BindBufferBase(u32 target, u32 index, u32 buffer);
+        void UseProgram(u32 program);
+
+        void BufferData(u32 target, size_t size, const void* data, u32 usage);
+        void BufferSubData(u32 target, size_t offset, size_t size, const void* data);
+
+        void DrawElements(u32 mode, i32 count, u32 type, const void* indices);
+
+        // The commands live in a GPU buffer, so the caller passes the index total along for the stats
+        void MultiDrawElementsIndirect(u32 mode, u32 type, const void* indirect, i32 draw_count, i32 stride, u64 total_indices);
+
+        void Uniform1i(i32 location, i32 value);
+        void Uniform1f(i32 location, f32 value);
+        void Uniform3fv(i32 location, const f32* value);
+        void Uniform4fv(i32 location, const f32* value);
+        void UniformMatrix4fv(i32 location, const f32* value);
+
+        // Deleted names may be handed out again, so they are dropped from the bound state
+        void DeleteBuffer(u32 buffer);
+        void DeleteVertexArray(u32 vao);
+        void DeleteProgram(u32 program);
+    }
+
+    class GLTrace {
+    public:
+        // Closes the current frame, called once per frame after rendering
+        static void EndFrame();
+
+        // Stats of the last closed frame, all zero without __GL_TRACE__
+        static const GLFrameStats& GetLastFrameStats();
+
+        // Appends one CSV line per frame to the file until stopped
+        static bool StartCapture(const std::string& path);
+        static void StopCapture();
+        static bool IsCapturing();
+    };
+}
+
+#endif // GL_TRACE_HPP
@@ -6,6 +6,13 @@
 #include "types.hpp"
 
 namespace std {
+    template <>
+    struct hash<glm::ivec2> {
+        std::size_t operator()(const glm::ivec2& key) const {
+            return (std::hash<i32>()(key.x) ^ (std::hash<i32>()(key.y) << 1));
+        }
+    };
+
     template <>
     struct hash<glm::ivec3> {
         std::size_t operator()(const glm::ivec3& key) const {
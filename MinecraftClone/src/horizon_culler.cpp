@@ -0,0 +1,212 @@
+#include "horizon_culler.hpp"
+#include "scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace MC {
+    // Bins only need an angle that grows monotonically around the circle, not an even spacing,
+    // so a diamond angle in [0, 4) stands in for atan2
+    static constexpr f32 PSEUDO_HALF_TURN = 2.0f;
+
+    static f32 GetPseudoAngle(const glm::vec2& direction) {
+        f32 sum = std::abs(direction.x) + std::abs(direction.y);
+        if (sum == 0.0f) {
+            return 0.0f;
+        }
+
+        f32 angle = direction.x / sum; // 1 along +x, -1 along -x
+        return direction.y >= 0.0f ? 1.0f - angle : 3.0f + angle;
+    }
+
+    void HorizonCuller::ComputeColumnBounds(SweepColumn& column, const glm::vec2& eye, const glm::vec2& min, const glm::vec2& max) const {
+        column.near_distance = glm::length(glm::clamp(eye, min, max) - eye);
+        column.far_distance = glm::length(glm::max(glm::abs(eye - min), glm::abs(eye - max)));
+
+        glm::vec2 to_center = (min + max) * 0.5f - eye;
+        f32 center_angle = GetPseudoAngle(to_center);
+
+        // Measure the corners relative to the center so ranges crossing the seam stay ordered
+        const glm::vec2 corners[4] = { { min.x, min.y }, { max.x, min.y }, { min.x, max.y }, { max.x, max.y } };
+        f32 min_offset = 0.0f;
+        f32 max_offset = 0.0f;
+        for (const glm::vec2& corner : corners) {
+            f32 offset = GetPseudoAngle(corner - eye) - center_angle;
+            if (offset > PSEUDO_HALF_TURN) {
+                offset -= 2.0f * PSEUDO_HALF_TURN;
+            }
+            else if (offset < -PSEUDO_HALF_TURN) {
+                offset += 2.0f * PSEUDO_HALF_TURN;
+            }
+            min_offset = std::min(min_offset, offset);
+            max_offset = std::max(max_offset, offset);
+        }
+
+        // Offsets reach down to minus half a turn, shifting by a turn keeps bin indices positive
+        f32 bins_per_unit = AZIMUTH_BINS / (2.0f * PSEUDO_HALF_TURN);
+        f32 start = (center_angle + min_offset) * bins_per_unit + AZIMUTH_BINS;
+        f32 end = (center_angle + max_offset) * bins_per_unit + AZIMUTH_BINS;
+
+        column.inner_range = { static_cast<i32>(std::ceil(start)), static_cast<i32>(std::floor(end)) - 1 };
+        column.outer_range = { static_cast<i32>(std::floor(start)), static_cast<i32>(std::floor(end)) };
+    }
+
+    void HorizonCuller::Cull(const Scene& scene, const glm::vec3& camera_pos, std::vector<VisibleChunk>& visible, CullingStats& stats) {
+        const auto& heights = scene.GetColumnHeights();
+
+        glm::ivec3 camera_voxel = glm::floor(camera_pos);
+        glm::ivec2 camera_column = glm::floor(glm::vec2(camera_voxel.x, camera_voxel.z) / static_cast<f32>(Chunk::CHUNK_SIZE));
+        auto camera_column_it = heights.find(camera_column);
+        if (camera_column_it == heights.end() || visible.empty()) {
+            return;
+        }
+
+        glm::ivec2 camera_local = glm::ivec2(camera_voxel.x, camera_voxel.z) - camera_column * Chunk::CHUNK_SIZE;
+        i32 surface_height = camera_column_it->second.heights[camera_local.x * Chunk::CHUNK_SIZE + camera_local.y];
+        if (camera_pos.y < static_cast<f32>(surface_height + 1)) {
+            return;
+        }
+
+        // Grid covering every known column and every visible chunk
+        glm::ivec2 grid_min = camera_column;
+        glm::ivec2 grid_max = camera_column;
+        for (const auto& [column_pos, column] : heights) {
+            grid_min = glm::min(grid_min, column_pos);
+            grid_max = glm::max(grid_max, column_pos);
+        }
+        for (const VisibleChunk& visible_chunk : visible) {
+            glm::ivec2 column_pos(visible_chunk.position.x, visible_chunk.position.z);
+            grid_min = glm::min(grid_min, column_pos);
+            grid_max = glm::max(grid_max, column_pos);
+        }
+
+        glm::ivec2 grid_size = grid_max - grid_min + 1;
+        auto GetCell = [&](const glm::ivec2& column_pos) {
+            return static_cast<size_t>((column_pos.y - grid_min.y) * grid_size.x + (column_pos.x - grid_min.x));
+        };
+
+        m_columns.assign(static_cast<size_t>(grid_size.x) * grid_size.y, SweepColumn{});
+
+        for (const auto& [column_pos, column] : heights) {
+            SweepColumn& sweep_column = m_columns[GetCell(column_pos)];
+            sweep_column.has_occluder = true;
+            sweep_column.occluder_height = column.min_height;
+        }
+
+        // Bucket the visible chunks by column
+        for (const VisibleChunk& visible_chunk : visible) {
+            ++m_columns[GetCell({ visible_chunk.position.x, visible_chunk.position.z })].chunk_count;
+        }
+
+        u32 first_chunk = 0;
+        for (SweepColumn& sweep_column : m_columns) {
+            sweep_column.first_chunk = first_chunk;
+            first_chunk += sweep_column.chunk_count;
+            sweep_column.chunk_count = 0;
+        }
+
+        m_column_chunks.resize(visible.size());
+        for (size_t i = 0; i < visible.size(); ++i) {
+            SweepColumn& sweep_column = m_columns[GetCell({ visible[i].position.x, visible[i].position.z })];
+            m_column_chunks[sweep_column.first_chunk + sweep_column.chunk_count++] = static_cast<u32>(i);
+        }
+
+        glm::vec2 eye(camera_pos.x, camera_pos.z);
+        m_events.clear();
+
+        // Distances are bucketed by whole blocks. Occluders round their far edge up and chunks round
+        // their near edge down, so an occluder sorted before a chunk lies entirely in front of it
+        u32 max_key = 0;
+        auto AddEvent = [&](f32 distance, bool is_occluder, u32 cell) {
+            u32 bucket = static_cast<u32>(is_occluder ? std::ceil(distance) : std::floor(distance));
+            u32 key = bucket * 2 + (is_occluder ? 0 : 1);
+            max_key = std::max(max_key, key);
+            m_events.push_back({ key, cell });
+        };
+
+        for (i32 z = 0; z < grid_size.y; ++z) {
+            for (i32 x = 0; x < grid_size.x; ++x) {
+                u32 cell = static_cast<u32>(z * grid_size.x + x);
+                SweepColumn& sweep_column = m_columns[cell];
+                if (!sweep_column.has_occluder && sweep_column.chunk_count == 0) {
+                    continue;
+                }
+
+                glm::vec2 column_min = glm::vec2((grid_min + glm::ivec2(x, z)) * Chunk::CHUNK_SIZE);
+                ComputeColumnBounds(sweep_column, eye, column_min, column_min + glm::vec2(Chunk::CHUNK_SIZE));
+
+                // The camera's own column is neither an occluder nor ever hidden
+                if (sweep_column.near_distance <= 0.0f) {
+                    continue;
+                }
+
+                if (sweep_column.has_occluder && sweep_column.inner_range.first_bin <= sweep_column.inner_range.last_bin) {
+                    AddEvent(sweep_column.far_distance, true, cell);
+                }
+                if (sweep_column.chunk_count > 0) {
+                    AddEvent(sweep_column.near_distance, false, cell);
+                }
+            }
+        }
+
+        // Counting sort on the key, front to back
+        m_key_offsets.assign(max_key + 2, 0);
+        for (const SweepEvent& event : m_events) {
+            ++m_key_offsets[event.key + 1];
+        }
+        for (size_t i = 1; i < m_key_offsets.size(); ++i) {
+            m_key_offsets[i] += m_key_offsets[i - 1];
+        }
+        m_sorted_events.resize(m_events.size());
+        for (const SweepEvent& event : m_events) {
+            m_sorted_events[m_key_offsets[event.key]++] = event;
+        }
+
+        m_horizon.assign(AZIMUTH_BINS, -std::numeric_limits<f32>::infinity());
+        m_hidden.assign(visible.size(), false);
+
+        for (const SweepEvent& event : m_sorted_events) {
+            const SweepColumn& sweep_column = m_columns[event.column];
+
+            if ((event.key & 1) == 0) {
+                // Any ray through the footprint meets it between its near and far edge, pick the
+                // distance giving the lowest elevation so the occluder never covers too much
+                f32 rise = static_cast<f32>(sweep_column.occluder_height + 1) - camera_pos.y;
+                f32 elevation = rise >= 0.0f ? rise / sweep_column.far_distance : rise / sweep_column.near_distance;
+
+                for (i32 bin = sweep_column.inner_range.first_bin; bin <= sweep_column.inner_range.last_bin; ++bin) {
+                    f32& horizon = m_horizon[bin % AZIMUTH_BINS];
+                    horizon = std::max(horizon, elevation);
+                }
+                continue;
+            }
+
+            // Lowest point of the horizon behind this column, shared by all of its chunks
+            f32 horizon = std::numeric_limits<f32>::infinity();
+            for (i32 bin = sweep_column.outer_range.first_bin; bin <= sweep_column.outer_range.last_bin; ++bin) {
+                horizon = std::min(horizon, m_horizon[bin % AZIMUTH_BINS]);
+            }
+
+            for (u32 i = 0; i < sweep_column.chunk_count; ++i) {
+                u32 chunk_index = m_column_chunks[sweep_column.first_chunk + i];
+
+                // Highest elevation any part of the chunk reaches
+                f32 rise = static_cast<f32>((visible[chunk_index].position.y + 1) * Chunk::CHUNK_SIZE) - camera_pos.y;
+                f32 elevation = rise >= 0.0f ? rise / sweep_column.near_distance : rise / sweep_column.far_distance;
+                m_hidden[chunk_index] = elevation < horizon;
+            }
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < visible.size(); ++i) {
+            if (!m_hidden[i]) {
+                visible[kept++] = visible[i];
+            }
+        }
+
+        stats.chunks_below_horizon += static_cast<u32>(visible.size() - kept);
+        visible.resize(kept);
+        stats.chunks_visible = static_cast<u32>(kept);
+    }
+}
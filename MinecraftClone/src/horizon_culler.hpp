@@ -0,0 +1,64 @@
+#ifndef HORIZON_CULLER_HPP
+#define HORIZON_CULLER_HPP
+
+#include "types.hpp"
+#include "chunk_region_grid.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace MC {
+    class Scene;
+
+    // 2.5D occlusion against the terrain heightmap. Chunk columns are treated as solid up to their
+    // lowest surface voxel and swept front to back into a horizon that stores, per azimuth around
+    // the camera, the steepest elevation that is hidden so far. A chunk whose top stays under the
+    // horizon across its whole azimuth range cannot be seen
+    class HorizonCuller {
+    public:
+        static constexpr i32 AZIMUTH_BINS = 1024;
+
+        // Removes chunks hidden behind terrain from the list. Does nothing while the camera is
+        // below the surface, where caves break the solid ground assumption
+        void Cull(const Scene& scene, const glm::vec3& camera_pos, std::vector<VisibleChunk>& visible, CullingStats& stats);
+
+    private:
+        struct AzimuthRange {
+            i32 first_bin;
+            i32 last_bin; // Inclusive, may run past AZIMUTH_BINS and wrap
+        };
+
+        // One chunk column of the area around the camera, as an occluder, as a set of visible chunks or both
+        struct SweepColumn {
+            bool has_occluder = false;
+            i32 occluder_height = 0;
+            u32 first_chunk = 0; // Slice of m_column_chunks
+            u32 chunk_count = 0;
+
+            f32 near_distance = 0.0f;
+            f32 far_distance = 0.0f;
+            AzimuthRange inner_range{}; // Bins the column fully covers
+            AzimuthRange outer_range{}; // Bins the column touches
+        };
+
+        // Occluders go in at their far edge, chunks are tested at their near edge
+        struct SweepEvent {
+            u32 key; // Distance bucket * 2, plus one for chunk tests so occluders sort first
+            u32 column;
+        };
+
+        void ComputeColumnBounds(SweepColumn& column, const glm::vec2& eye, const glm::vec2& min, const glm::vec2& max) const;
+
+        // Tangent of the elevation angle per azimuth bin
+        std::vector<f32> m_horizon;
+
+        // Dense grid over the columns around the camera
+        std::vector<SweepColumn> m_columns;
+        std::vector<u32> m_column_chunks;
+        std::vector<SweepEvent> m_events;
+        std::vector<u32> m_key_offsets;
+        std::vector<SweepEvent> m_sorted_events;
+        std::vector<bool> m_hidden;
+    };
+}
+
+#endif // HORIZON_CULLER_HPP
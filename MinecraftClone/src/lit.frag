@@ -5,28 +5,32 @@ in vec4 VertexColor;
 
 out vec4 FragColor;
 
-uniform vec3 lightDirection;
-uniform vec3 lightColor;
-uniform vec3 ambientLightColor;
-uniform vec3 viewPos; // Camera position
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // Camera position
+    vec4 lightDirection;
+    vec4 lightColor;
+    vec4 ambientLightColor;
+};
 
 void main()
 {
         vec3 norm = normalize(Normal);
-        vec3 lightDir = normalize(-lightDirection);
+        vec3 lightDir = normalize(-lightDirection.xyz);
 
         // Ambient component
-        vec3 ambient = ambientLightColor * VertexColor.rgb;
+        vec3 ambient = ambientLightColor.rgb * VertexColor.rgb;
 
         // Diffuse component
         float diff = max(dot(norm, lightDir), 0.0);
-        vec3 diffuse = diff * lightColor * VertexColor.rgb;
+        vec3 diffuse = diff * lightColor.rgb * VertexColor.rgb;
 
         // Specular component
-        vec3 viewDir = normalize(viewPos - FragPos);
+        vec3 viewDir = normalize(viewPos.xyz - FragPos);
         vec3 reflectDir = reflect(-lightDir, norm);
         float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32); // Shininess factor
-        vec3 specular = spec * lightColor;
+        vec3 specular = spec * lightColor.rgb;
 
         // Combine results
         vec3 result = ambient + diffuse + specular;
@@ -2,10 +2,16 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec4 aColor; // Color attribute
+layout(location = 3) in vec3 aChunkOffset; // Per-draw chunk position
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightDirection;
+    vec4 lightColor;
+    vec4 ambientLightColor;
+};
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -13,8 +19,9 @@ out vec4 VertexColor; // Pass to fragment shader
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    // Chunks are only ever translated, so normals need no transform
+    FragPos = aPos + aChunkOffset;
+    Normal = aNormal;
     VertexColor = aColor;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
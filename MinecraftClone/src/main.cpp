@@ -1,5 +1,10 @@
 #include "application.hpp"
+#include "benchmark.hpp"
 #include "fps.hpp"
+#include "gl_trace.hpp"
+#include "render_benchmark.hpp"
+#include "streaming_benchmark.hpp"
+#include "world_hash.hpp"
 
 #include <GLM/gtc/noise.hpp>
 #include <random>
@@ -244,10 +249,109 @@ void DisableLighting(MC::Application& app, MC::EventPtr<MC::KeyPressedEvent> eve
 	}
 }
 
-i32 main() {
+void ToggleOcclusionCulling(MC::Application& app, MC::EventPtr<MC::KeyPressedEvent> event)
+{
+	if (event->key == GLFW_KEY_O)
+	{
+		MC::Renderer& renderer = app.GetRenderer();
+		renderer.EnableOcclusionCulling(!renderer.IsOcclusionCullingEnabled());
+		LOG_INFO("Occlusion culling " << (renderer.IsOcclusionCullingEnabled() ? "enabled" : "disabled"));
+	}
+}
+
+void ToggleHorizonCulling(MC::Application& app, MC::EventPtr<MC::KeyPressedEvent> event)
+{
+	if (event->key == GLFW_KEY_H)
+	{
+		MC::Renderer& renderer = app.GetRenderer();
+		renderer.EnableHorizonCulling(!renderer.IsHorizonCullingEnabled());
+		LOG_INFO("Horizon culling " << (renderer.IsHorizonCullingEnabled() ? "enabled" : "disabled"));
+	}
+}
+
+void ToggleGLTraceCapture(MC::Application& app, MC::EventPtr<MC::KeyPressedEvent> event)
+{
+	if (event->key == GLFW_KEY_F9)
+	{
+		if (MC::GLTrace::IsCapturing()) {
+			MC::GLTrace::StopCapture();
+		}
+		else {
+			MC::GLTrace::StartCapture("gl_trace.csv");
+		}
+	}
+}
+
+i32 main(i32 argc, char** argv) {
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-culling") {
+		MC::RunCullingBenchmark();
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-frustum") {
+		MC::RunFrustumBenchmark();
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-noise") {
+		MC::RunNoiseBenchmark();
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-caves") {
+		MC::RunCaveBenchmark();
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-render") {
+		// --benchmark-render [width height [frames]]
+		MC::RenderBenchmarkSettings settings;
+		if (argc > 3) {
+			settings.width = std::stoi(argv[2]);
+			settings.height = std::stoi(argv[3]);
+		}
+		if (argc > 4) {
+			settings.frames = static_cast<u32>(std::stoul(argv[4]));
+		}
+		MC::RunRenderBenchmark(settings);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-streaming") {
+		// --benchmark-streaming [frames [blocks per frame]]
+		MC::StreamingBenchmarkSettings settings;
+		if (argc > 2) {
+			settings.frames = static_cast<u32>(std::stoul(argv[2]));
+		}
+		if (argc > 3) {
+			settings.speed = std::stof(argv[3]);
+		}
+		MC::RunStreamingBenchmark(settings);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--world-hash") {
+		// --world-hash [seed [radius [threads [golden file]]]]
+		MC::WorldHashSettings settings;
+		if (argc > 2) {
+			settings.seed = static_cast<u32>(std::stoul(argv[2]));
+		}
+		if (argc > 3) {
+			settings.radius = std::stoi(argv[3]);
+		}
+		if (argc > 4) {
+			settings.threads = static_cast<u32>(std::stoul(argv[4]));
+		}
+		if (argc > 5) {
+			settings.golden_path = argv[5];
+		}
+		return MC::RunWorldHash(settings) ? 0 : 1;
+	}
+
 	MC::Application app;
 	MC::FPSCounter fps_counter;
 
+	// --seed N picks the world, a random one otherwise
+	for (i32 i = 1; i + 1 < argc; ++i) {
+		if (std::string(argv[i]) == "--seed") {
+			app.GetScene().SetSeed(static_cast<u32>(std::stoul(argv[i + 1])));
+		}
+	}
+
 	// Add features via method chaining
 	app.CreateWindow("Minecraft Clone", 1000, 1000)
 		.AddStartupFunction([](MC::Application& app) {
@@ -272,6 +376,9 @@ i32 main() {
 			})
 			*/
 		.AddEventFunction<MC::KeyPressedEvent>(DisableLighting)
+		.AddEventFunction<MC::KeyPressedEvent>(ToggleOcclusionCulling)
+		.AddEventFunction<MC::KeyPressedEvent>(ToggleHorizonCulling)
+		.AddEventFunction<MC::KeyPressedEvent>(ToggleGLTraceCapture)
 		.AddEventFunction<MC::KeyPressedEvent, MC::KeyHeldEvent>(MoveCameraOnKeyPress)
 		.AddEventFunction<MC::MouseMovedEvent>(RotateCameraOnMouseMove)
 		.AddEventFunction<MC::MouseScrolledEvent>(ZoomCamera)
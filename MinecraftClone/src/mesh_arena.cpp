@@ -0,0 +1,297 @@
+#include "mesh_arena.hpp"
+#include "log.hpp"
+#include "gl_trace.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+
+namespace MC {
+    namespace {
+        size_t GetMeshBytes(const MeshAllocation& allocation) {
+            return static_cast<size_t>(allocation.vertex_count) * sizeof(Vertex) + static_cast<size_t>(allocation.index_count) * sizeof(u32);
+        }
+
+        void CountUpload(MeshSinkStats& stats, const MeshAllocation& allocation) {
+            size_t bytes = GetMeshBytes(allocation);
+            ++stats.uploads;
+            ++stats.live_meshes;
+            stats.uploaded_bytes += bytes;
+            stats.live_bytes += bytes;
+        }
+
+        void CountFree(MeshSinkStats& stats, const MeshAllocation& allocation) {
+            ++stats.frees;
+            --stats.live_meshes;
+            stats.live_bytes -= GetMeshBytes(allocation);
+        }
+
+        // Same growth as the arena buffers, without anything to copy
+        u32 AllocateRecordedRange(FreeListAllocator& allocator, u32 count) {
+            std::optional<u32> offset = allocator.Allocate(count);
+            if (!offset.has_value()) {
+                allocator.Grow(std::max(allocator.GetCapacity() * 2, allocator.GetCapacity() + count));
+                offset = allocator.Allocate(count);
+            }
+            return offset.value();
+        }
+    }
+
+    FreeListAllocator::FreeListAllocator(u32 capacity)
+        : m_capacity(capacity) {
+        if (capacity > 0) {
+            m_free_blocks.emplace(0, capacity);
+        }
+    }
+
+    std::optional<u32> FreeListAllocator::Allocate(u32 size) {
+        for (auto it = m_free_blocks.begin(); it != m_free_blocks.end(); ++it) {
+            if (it->second < size) {
+                continue;
+            }
+
+            u32 offset = it->first;
+            u32 remaining = it->second - size;
+            m_free_blocks.erase(it);
+
+            if (remaining > 0) {
+                m_free_blocks.emplace(offset + size, remaining);
+            }
+
+            m_used += size;
+            return offset;
+        }
+
+        return std::nullopt;
+    }
+
+    void FreeListAllocator::Free(u32 offset, u32 size) {
+        if (size == 0) {
+            return;
+        }
+
+        m_used -= size;
+
+        auto next = m_free_blocks.lower_bound(offset);
+
+        // Merge with the following block
+        if (next != m_free_blocks.end() && offset + size == next->first) {
+            size += next->second;
+            next = m_free_blocks.erase(next);
+        }
+
+        // Merge with the preceding block
+        if (next != m_free_blocks.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return;
+            }
+        }
+
+        m_free_blocks.emplace(offset, size);
+    }
+
+    void FreeListAllocator::Grow(u32 new_capacity) {
+        if (new_capacity <= m_capacity) {
+            return;
+        }
+
+        u32 old_capacity = m_capacity;
+        m_capacity = new_capacity;
+
+        // Put the used count back after Free subtracts it for the appended block
+        m_used += new_capacity - old_capacity;
+        Free(old_capacity, new_capacity - old_capacity);
+    }
+
+    ChunkMeshArena::ChunkMeshArena(GLResourceManager& resources, u32 vertex_capacity, u32 index_capacity)
+        : m_resources(resources) {
+        if (!GLEW_VERSION_4_3 && !GLEW_ARB_multi_draw_indirect) {
+            LOG_FATAL("Chunk rendering requires glMultiDrawElementsIndirect (OpenGL 4.3 or ARB_multi_draw_indirect)");
+        }
+
+        // Size classes may round the buffers up, use whatever was handed out
+        m_vbo = m_resources.AcquireBuffer(static_cast<size_t>(vertex_capacity) * sizeof(Vertex));
+        m_ebo = m_resources.AcquireBuffer(static_cast<size_t>(index_capacity) * sizeof(u32));
+        m_vertex_allocator = FreeListAllocator(static_cast<u32>(m_vbo.size / sizeof(Vertex)));
+        m_index_allocator = FreeListAllocator(static_cast<u32>(m_ebo.size / sizeof(u32)));
+
+        m_vao = m_resources.CreateVertexArray();
+        GL::BindVertexArray(m_vao);
+
+        GL::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo.id);
+        SetupVertexAttributes();
+
+        // Per-draw chunk offset, advanced once per instance so base_instance selects it
+        glEnableVertexAttribArray(CHUNK_OFFSET_ATTRIB_INDEX);
+        glVertexAttribDivisor(CHUNK_OFFSET_ATTRIB_INDEX, 1);
+
+        GL::BindVertexArray(0);
+    }
+
+    ChunkMeshArena::~ChunkMeshArena() {
+        m_resources.ReleaseBuffer(m_ebo);
+        m_resources.ReleaseBuffer(m_vbo);
+        m_resources.ReleaseVertexArray(m_vao);
+    }
+
+    void ChunkMeshArena::SetupVertexAttributes() {
+        GL::BindBuffer(GL_ARRAY_BUFFER, m_vbo.id);
+
+        glEnableVertexAttribArray(0); // Position
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
+
+        glEnableVertexAttribArray(1); // Normal
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+
+        glEnableVertexAttribArray(2); // Color attribute
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    }
+
+    MeshAllocation ChunkMeshArena::Upload(const std::vector<Vertex>& vertices, const std::vector<u32>& indices) {
+        MeshAllocation allocation;
+        if (indices.empty()) {
+            return allocation;
+        }
+
+        allocation.vertex_count = static_cast<u32>(vertices.size());
+        allocation.index_count = static_cast<u32>(indices.size());
+        allocation.vertex_offset = AllocateRange(m_vertex_allocator, m_vbo, GL_ARRAY_BUFFER, sizeof(Vertex), allocation.vertex_count);
+        allocation.index_offset = AllocateRange(m_index_allocator, m_ebo, GL_ELEMENT_ARRAY_BUFFER, sizeof(u32), allocation.index_count);
+
+        // The element buffer binding is VAO state, keep the arena VAO bound while touching it
+        GL::BindVertexArray(m_vao);
+
+        GL::BindBuffer(GL_ARRAY_BUFFER, m_vbo.id);
+        GL::BufferSubData(GL_ARRAY_BUFFER, static_cast<size_t>(allocation.vertex_offset) * sizeof(Vertex), vertices.size() * sizeof(Vertex), vertices.data());
+
+        GL::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo.id);
+        GL::BufferSubData(GL_ELEMENT_ARRAY_BUFFER, static_cast<size_t>(allocation.index_offset) * sizeof(u32), indices.size() * sizeof(u32), indices.data());
+
+        GL::BindVertexArray(0);
+
+        CountUpload(m_stats, allocation);
+        return allocation;
+    }
+
+    void ChunkMeshArena::Free(MeshAllocation& allocation) {
+        if (!allocation.IsValid()) {
+            return;
+        }
+
+        m_vertex_allocator.Free(allocation.vertex_offset, allocation.vertex_count);
+        m_index_allocator.Free(allocation.index_offset, allocation.index_count);
+        CountFree(m_stats, allocation);
+        allocation = MeshAllocation{};
+    }
+
+    const MeshSinkStats& ChunkMeshArena::GetStats() const {
+        return m_stats;
+    }
+
+    u32 ChunkMeshArena::AllocateRange(FreeListAllocator& allocator, GLBuffer& buffer, u32 target, size_t element_size, u32 count) {
+        std::optional<u32> offset = allocator.Allocate(count);
+        if (!offset.has_value()) {
+            GrowBuffer(allocator, buffer, target, element_size, allocator.GetCapacity() + count);
+            offset = allocator.Allocate(count);
+        }
+        return offset.value();
+    }
+
+    void ChunkMeshArena::GrowBuffer(FreeListAllocator& allocator, GLBuffer& buffer, u32 target, size_t element_size, u32 min_capacity) {
+        u32 old_capacity = allocator.GetCapacity();
+        GLBuffer new_buffer = m_resources.AcquireBuffer(std::max(static_cast<size_t>(old_capacity) * 2, static_cast<size_t>(min_capacity)) * element_size);
+        u32 new_capacity = static_cast<u32>(new_buffer.size / element_size);
+
+        LOG_TRACE("Growing chunk mesh arena buffer from " << old_capacity << " to " << new_capacity << " elements");
+
+        GL::BindBuffer(GL_COPY_READ_BUFFER, buffer.id);
+        GL::BindBuffer(GL_COPY_WRITE_BUFFER, new_buffer.id);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<size_t>(old_capacity) * element_size);
+
+        GL::BindBuffer(GL_COPY_READ_BUFFER, 0);
+        GL::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        // Frames already submitted may still read the old buffer, the manager holds on to it
+        m_resources.ReleaseBuffer(buffer);
+        buffer = new_buffer;
+
+        // Point the VAO at the replacement buffer
+        GL::BindVertexArray(m_vao);
+        if (target == GL_ELEMENT_ARRAY_BUFFER) {
+            GL::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo.id);
+        }
+        else {
+            SetupVertexAttributes();
+        }
+        GL::BindVertexArray(0);
+
+        allocator.Grow(new_capacity);
+    }
+
+    void ChunkMeshArena::Draw(const std::vector<DrawElementsIndirectCommand>& commands, const std::vector<glm::vec4>& chunk_offsets) {
+        if (commands.empty()) {
+            return;
+        }
+
+        size_t offsets_size = chunk_offsets.size() * sizeof(glm::vec4);
+        size_t commands_size = commands.size() * sizeof(DrawElementsIndirectCommand);
+
+        // Fresh buffers every frame, the manager recycles them once the GPU is done with them
+        GLBuffer offset_buffer = m_resources.AcquireBuffer(offsets_size);
+        GLBuffer indirect_buffer = m_resources.AcquireBuffer(commands_size);
+
+        GL::BindVertexArray(m_vao);
+
+        GL::BindBuffer(GL_ARRAY_BUFFER, offset_buffer.id);
+        GL::BufferSubData(GL_ARRAY_BUFFER, 0, offsets_size, chunk_offsets.data());
+        glVertexAttribPointer(CHUNK_OFFSET_ATTRIB_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+
+        GL::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer.id);
+        GL::BufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands_size, commands.data());
+
+        // The GL trace cannot read the commands back from the buffer
+        u64 total_indices = 0;
+        for (const DrawElementsIndirectCommand& command : commands) {
+            total_indices += command.count;
+        }
+
+        GL::MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0, total_indices);
+
+        GL::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        GL::BindVertexArray(0);
+
+        m_resources.ReleaseBuffer(offset_buffer);
+        m_resources.ReleaseBuffer(indirect_buffer);
+    }
+
+    MeshAllocation RecordingMeshSink::Upload(const std::vector<Vertex>& vertices, const std::vector<u32>& indices) {
+        MeshAllocation allocation;
+        if (indices.empty()) {
+            return allocation;
+        }
+
+        allocation.vertex_count = static_cast<u32>(vertices.size());
+        allocation.index_count = static_cast<u32>(indices.size());
+        allocation.vertex_offset = AllocateRecordedRange(m_vertex_allocator, allocation.vertex_count);
+        allocation.index_offset = AllocateRecordedRange(m_index_allocator, allocation.index_count);
+
+        CountUpload(m_stats, allocation);
+        return allocation;
+    }
+
+    void RecordingMeshSink::Free(MeshAllocation& allocation) {
+        if (!allocation.IsValid()) {
+            return;
+        }
+
+        m_vertex_allocator.Free(allocation.vertex_offset, allocation.vertex_count);
+        m_index_allocator.Free(allocation.index_offset, allocation.index_count);
+        CountFree(m_stats, allocation);
+        allocation = MeshAllocation{};
+    }
+
+    const MeshSinkStats& RecordingMeshSink::GetStats() const {
+        return m_stats;
+    }
+}
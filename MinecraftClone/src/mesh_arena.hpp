@@ -0,0 +1,130 @@
+#ifndef MESH_ARENA_HPP
+#define MESH_ARENA_HPP
+
+#include "types.hpp"
+#include "vertex.hpp"
+#include "gl_resource_manager.hpp"
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace MC {
+    // Layout mandated by glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand {
+        u32 count;
+        u32 instance_count;
+        u32 first_index;
+        i32 base_vertex;
+        u32 base_instance;
+    };
+
+    // Range of a chunk mesh inside the shared vertex and index buffers
+    struct MeshAllocation {
+        u32 vertex_offset = 0;
+        u32 vertex_count = 0;
+        u32 index_offset = 0;
+        u32 index_count = 0;
+
+        bool IsValid() const { return index_count != 0; }
+    };
+
+    struct MeshSinkStats {
+        u64 uploads = 0;
+        u64 uploaded_bytes = 0;
+        u64 frees = 0;
+        u64 live_meshes = 0;
+        u64 live_bytes = 0;
+    };
+
+    // Where finished chunk meshes go, the GPU arena when rendering and a recording stand-in without GL
+    class IChunkMeshSink {
+    public:
+        virtual ~IChunkMeshSink() = default;
+
+        // Reserves space for a mesh and takes a copy of it, an empty mesh returns an invalid allocation
+        virtual MeshAllocation Upload(const std::vector<Vertex>& vertices, const std::vector<u32>& indices) = 0;
+        virtual void Free(MeshAllocation& allocation) = 0;
+
+        virtual const MeshSinkStats& GetStats() const = 0;
+    };
+
+    // First-fit free-list over a range of elements, neighbouring free blocks are coalesced
+    class FreeListAllocator {
+    public:
+        explicit FreeListAllocator(u32 capacity = 0);
+
+        std::optional<u32> Allocate(u32 size);
+        void Free(u32 offset, u32 size);
+
+        // Extends the range, the new space is appended as a free block
+        void Grow(u32 new_capacity);
+
+        u32 GetCapacity() const { return m_capacity; }
+        u32 GetUsed() const { return m_used; }
+
+    private:
+        // Free blocks keyed by offset
+        std::map<u32, u32> m_free_blocks;
+        u32 m_capacity;
+        u32 m_used = 0;
+    };
+
+    // One VAO and one vertex/index buffer pair shared by every chunk mesh
+    class ChunkMeshArena : public IChunkMeshSink {
+    public:
+        static constexpr u32 DEFAULT_VERTEX_CAPACITY = 1 << 21;
+        static constexpr u32 DEFAULT_INDEX_CAPACITY = 3 << 20;
+
+        // Attribute location of the per-draw chunk offset, fed through base_instance
+        static constexpr u32 CHUNK_OFFSET_ATTRIB_INDEX = 3;
+
+        ChunkMeshArena(GLResourceManager& resources, u32 vertex_capacity = DEFAULT_VERTEX_CAPACITY, u32 index_capacity = DEFAULT_INDEX_CAPACITY);
+        ~ChunkMeshArena() override;
+        ChunkMeshArena(const ChunkMeshArena&) = delete;
+        ChunkMeshArena& operator=(const ChunkMeshArena&) = delete;
+
+        MeshAllocation Upload(const std::vector<Vertex>& vertices, const std::vector<u32>& indices) override;
+        void Free(MeshAllocation& allocation) override;
+        const MeshSinkStats& GetStats() const override;
+
+        // Issues every command with a single glMultiDrawElementsIndirect call
+        void Draw(const std::vector<DrawElementsIndirectCommand>& commands, const std::vector<glm::vec4>& chunk_offsets);
+
+        u32 GetVAO() const { return m_vao; }
+        u32 GetVertexCapacity() const { return m_vertex_allocator.GetCapacity(); }
+        u32 GetIndexCapacity() const { return m_index_allocator.GetCapacity(); }
+        u32 GetVerticesUsed() const { return m_vertex_allocator.GetUsed(); }
+        u32 GetIndicesUsed() const { return m_index_allocator.GetUsed(); }
+
+    private:
+        u32 AllocateRange(FreeListAllocator& allocator, GLBuffer& buffer, u32 target, size_t element_size, u32 count);
+        void GrowBuffer(FreeListAllocator& allocator, GLBuffer& buffer, u32 target, size_t element_size, u32 min_capacity);
+        void SetupVertexAttributes();
+
+    private:
+        GLResourceManager& m_resources;
+        u32 m_vao = 0;
+        GLBuffer m_vbo;
+        GLBuffer m_ebo;
+
+        FreeListAllocator m_vertex_allocator;
+        FreeListAllocator m_index_allocator;
+        MeshSinkStats m_stats;
+    };
+
+    // Lays meshes out like the arena would but keeps nothing, so chunk streaming and meshing can
+    // run without a GL context
+    class RecordingMeshSink : public IChunkMeshSink {
+    public:
+        MeshAllocation Upload(const std::vector<Vertex>& vertices, const std::vector<u32>& indices) override;
+        void Free(MeshAllocation& allocation) override;
+        const MeshSinkStats& GetStats() const override;
+
+    private:
+        FreeListAllocator m_vertex_allocator;
+        FreeListAllocator m_index_allocator;
+        MeshSinkStats m_stats;
+    };
+}
+
+#endif // MESH_ARENA_HPP
@@ -0,0 +1,69 @@
+#include "mesh_upload_queue.hpp"
+#include "chunk.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace MC {
+    void MeshUploadQueue::SetBudget(const MeshUploadBudget& budget) {
+        m_budget = budget;
+    }
+
+    const MeshUploadBudget& MeshUploadQueue::GetBudget() const {
+        return m_budget;
+    }
+
+    void MeshUploadQueue::Push(const std::shared_ptr<Chunk>& chunk, f32 priority) {
+        m_entries.push_back({ priority, chunk });
+    }
+
+    void MeshUploadQueue::Process(IChunkMeshSink& sink) {
+        auto start = std::chrono::steady_clock::now();
+
+        std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+            return a.priority < b.priority;
+            });
+
+        m_stats = MeshUploadStats{};
+        m_uploaded_chunks.clear();
+
+        size_t uploaded = 0;
+        for (; uploaded < m_entries.size(); ++uploaded) {
+            Chunk& chunk = *m_entries[uploaded].chunk;
+            size_t bytes = chunk.GetPendingUploadBytes();
+
+            // Always let the first mesh through so a single oversized chunk cannot stall the queue
+            if (uploaded > 0 && m_budget.max_bytes_per_frame > 0 &&
+                m_stats.uploaded_bytes + bytes > m_budget.max_bytes_per_frame) {
+                break;
+            }
+
+            chunk.UploadMeshData(sink);
+            m_uploaded_chunks.push_back(&chunk);
+            m_stats.uploaded_bytes += bytes;
+            ++m_stats.uploaded_chunks;
+
+            if (m_budget.max_microseconds_per_frame > 0) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                if (static_cast<u64>(elapsed.count()) >= m_budget.max_microseconds_per_frame) {
+                    ++uploaded;
+                    break;
+                }
+            }
+        }
+
+        m_stats.queue_depth = m_entries.size() - uploaded;
+        m_stats.upload_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        // The scene re-queues whatever is still pending next frame with fresh priorities
+        m_entries.clear();
+    }
+
+    const MeshUploadStats& MeshUploadQueue::GetStats() const {
+        return m_stats;
+    }
+
+    const std::vector<Chunk*>& MeshUploadQueue::GetUploadedChunks() const {
+        return m_uploaded_chunks;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef MESH_UPLOAD_QUEUE_HPP
+#define MESH_UPLOAD_QUEUE_HPP
+
+#include "types.hpp"
+#include "mesh_arena.hpp"
+#include <memory>
+#include <vector>
+
+namespace MC {
+    class Chunk;
+
+    // Per-frame limits, whichever is hit first ends the frame's uploads. Zero disables a limit
+    struct MeshUploadBudget {
+        size_t max_bytes_per_frame = 4 * 1024 * 1024;
+        u64 max_microseconds_per_frame = 2000;
+    };
+
+    struct MeshUploadStats {
+        size_t queue_depth = 0;       // Meshes still waiting after this frame's uploads
+        size_t uploaded_chunks = 0;
+        size_t uploaded_bytes = 0;
+        u64 upload_microseconds = 0;
+    };
+
+    // Spreads finished chunk meshes over several frames instead of uploading them all at once
+    class MeshUploadQueue {
+    public:
+        void SetBudget(const MeshUploadBudget& budget);
+        const MeshUploadBudget& GetBudget() const;
+
+        // Lower priority values are uploaded first
+        void Push(const std::shared_ptr<Chunk>& chunk, f32 priority);
+
+        // Uploads the queued meshes in priority order until the budget is spent, then clears the queue
+        void Process(IChunkMeshSink& sink);
+
+        const MeshUploadStats& GetStats() const;
+
+        // Chunks whose mesh went up in the last Process call
+        const std::vector<Chunk*>& GetUploadedChunks() const;
+
+    private:
+        struct Entry {
+            f32 priority;
+            std::shared_ptr<Chunk> chunk;
+        };
+
+        std::vector<Entry> m_entries;
+        std::vector<Chunk*> m_uploaded_chunks;
+        MeshUploadBudget m_budget;
+        MeshUploadStats m_stats;
+    };
+}
+
+#endif // MESH_UPLOAD_QUEUE_HPP
@@ -0,0 +1,39 @@
+#include "noise_lattice.hpp"
+
+namespace MC {
+    void UpsampleLattice3D(const f32* lattice, i32 size, i32 spacing, f32* values) {
+        const i32 samples = GetLatticeSamplesPerAxis(size, spacing);
+        const f32 inverse_spacing = 1.0f / spacing;
+
+        for (i32 z = 0; z < size; ++z) {
+            i32 lz = z / spacing;
+            f32 tz = (z % spacing) * inverse_spacing;
+
+            for (i32 y = 0; y < size; ++y) {
+                i32 ly = y / spacing;
+                f32 ty = (y % spacing) * inverse_spacing;
+
+                // The four lattice rows around this voxel row
+                const f32* row_00 = lattice + (lz * samples + ly) * samples;
+                const f32* row_10 = row_00 + samples;
+                const f32* row_01 = row_00 + samples * samples;
+                const f32* row_11 = row_01 + samples;
+                f32* out = values + (z * size + y) * size;
+
+                for (i32 x = 0; x < size; ++x) {
+                    i32 lx = x / spacing;
+                    f32 tx = (x % spacing) * inverse_spacing;
+
+                    f32 near_low = row_00[lx] + (row_00[lx + 1] - row_00[lx]) * tx;
+                    f32 near_high = row_10[lx] + (row_10[lx + 1] - row_10[lx]) * tx;
+                    f32 far_low = row_01[lx] + (row_01[lx + 1] - row_01[lx]) * tx;
+                    f32 far_high = row_11[lx] + (row_11[lx + 1] - row_11[lx]) * tx;
+
+                    f32 near = near_low + (near_high - near_low) * ty;
+                    f32 far = far_low + (far_high - far_low) * ty;
+                    out[x] = near + (far - near) * tz;
+                }
+            }
+        }
+    }
+}
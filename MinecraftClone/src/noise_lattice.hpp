@@ -0,0 +1,17 @@
+#ifndef NOISE_LATTICE_HPP
+#define NOISE_LATTICE_HPP
+
+#include "types.hpp"
+
+namespace MC {
+    // Samples per axis of a lattice covering size voxels every spacing voxels, including the sample on the far side
+    constexpr i32 GetLatticeSamplesPerAxis(i32 size, i32 spacing) {
+        return size / spacing + 1;
+    }
+
+    // Trilinearly interpolates a cube lattice of noise samples to one value per voxel. Both the lattice and the
+    // values are ordered x fastest, then y, then z, like FastNoise grids. spacing must divide size
+    void UpsampleLattice3D(const f32* lattice, i32 size, i32 spacing, f32* values);
+}
+
+#endif // NOISE_LATTICE_HPP
@@ -0,0 +1,102 @@
+#include "occlusion_culler.hpp"
+#include "scene.hpp"
+
+namespace MC {
+    static const glm::ivec3 FACE_DIRECTIONS[6] = {
+        {1, 0, 0},   // POS_X
+        {-1, 0, 0},  // NEG_X
+        {0, 1, 0},   // POS_Y
+        {0, -1, 0},  // NEG_Y
+        {0, 0, 1},   // POS_Z
+        {0, 0, -1}   // NEG_Z
+    };
+
+    void OcclusionCuller::Cull(Scene& scene, const glm::vec3& camera_pos, const Frustum& frustum, std::vector<VisibleChunk>& visible, CullingStats& stats) {
+        auto& chunks = scene.GetChunks();
+        glm::ivec3 camera_chunk = glm::floor(camera_pos / static_cast<f32>(Chunk::CHUNK_SIZE));
+
+        ++m_frame;
+
+        // Stamping the frustum result lets the walk stay inside the view without testing boxes again.
+        // Every path only moves away from the camera, so it never leaves the box around the camera and the
+        // chunks it can reach, which keeps the walk through missing chunks bounded
+        glm::ivec3 walk_min = camera_chunk;
+        glm::ivec3 walk_max = camera_chunk;
+        for (const VisibleChunk& visible_chunk : visible) {
+            ChunkVisibilityStamp& stamp = visible_chunk.chunk->GetVisibilityStamp();
+            stamp.in_frustum_frame = m_frame;
+            stamp.render_row = visible_chunk.row;
+            walk_min = glm::min(walk_min, visible_chunk.position);
+            walk_max = glm::max(walk_max, visible_chunk.position);
+        }
+
+        size_t frustum_visible = visible.size();
+        visible.clear();
+
+        m_visited_missing.clear();
+        m_queue.clear();
+
+        auto start_it = chunks.find(camera_chunk);
+        Chunk* start_chunk = start_it != chunks.end() ? start_it->second.get() : nullptr;
+        if (start_chunk) {
+            start_chunk->GetVisibilityStamp().visited_frame = m_frame;
+        }
+        else {
+            m_visited_missing.insert(camera_chunk);
+        }
+        m_queue.push_back({ camera_chunk, start_chunk, NO_FACE, 0 });
+
+        for (size_t head = 0; head < m_queue.size(); ++head) {
+            Step step = m_queue[head];
+
+            if (step.chunk && step.chunk->GetVisibilityStamp().in_frustum_frame == m_frame) {
+                visible.push_back({ step.position, step.chunk, step.chunk->GetVisibilityStamp().render_row });
+            }
+
+            for (i32 face = 0; face < 6; ++face) {
+                // Faces come in positive/negative pairs, so flipping the low bit gives the opposite one
+                i32 opposite_face = face ^ 1;
+
+                // Never head back towards the camera, every path only moves away along each axis
+                if (step.directions & (1 << opposite_face)) {
+                    continue;
+                }
+
+                // A missing chunk is air, connected on every face
+                if (step.chunk && step.entry_face != NO_FACE && !step.chunk->AreFacesConnected(step.entry_face, face)) {
+                    continue;
+                }
+
+                glm::ivec3 next_pos = step.position + FACE_DIRECTIONS[face];
+                if (glm::any(glm::lessThan(next_pos, walk_min)) || glm::any(glm::greaterThan(next_pos, walk_max))) {
+                    continue;
+                }
+
+                Step next = { next_pos, nullptr, static_cast<i8>(opposite_face), static_cast<u8>(step.directions | (1 << face)) };
+
+                // Nothing to draw in a missing chunk, the walk passes through it while it is in view
+                auto next_it = chunks.find(next_pos);
+                if (next_it == chunks.end()) {
+                    glm::vec3 chunk_min = glm::vec3(next_pos * Chunk::CHUNK_SIZE);
+                    if (!frustum.IsBoxVisible(chunk_min, chunk_min + static_cast<f32>(Chunk::CHUNK_SIZE)) || !m_visited_missing.insert(next_pos).second) {
+                        continue;
+                    }
+                    m_queue.push_back(next);
+                    continue;
+                }
+
+                next.chunk = next_it->second.get();
+                ChunkVisibilityStamp& stamp = next.chunk->GetVisibilityStamp();
+                if (stamp.visited_frame == m_frame || stamp.in_frustum_frame != m_frame) {
+                    continue;
+                }
+
+                stamp.visited_frame = m_frame;
+                m_queue.push_back(next);
+            }
+        }
+
+        stats.chunks_occluded += static_cast<u32>(frustum_visible - visible.size());
+        stats.chunks_visible = static_cast<u32>(visible.size());
+    }
+}
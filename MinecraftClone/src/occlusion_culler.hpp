@@ -0,0 +1,38 @@
+#ifndef OCCLUSION_CULLER_HPP
+#define OCCLUSION_CULLER_HPP
+
+#include "types.hpp"
+#include "chunk_region_grid.hpp"
+#include <glm/glm.hpp>
+#include <unordered_set>
+#include <vector>
+
+namespace MC {
+    class Scene;
+
+    // Cave culling: walks outwards from the camera's chunk through chunk faces that air connects,
+    // anything in the frustum the walk never reaches is hidden behind solid terrain. Chunks that are
+    // not loaded count as air, streaming never creates the empty ones above the terrain
+    class OcclusionCuller {
+    public:
+        // Narrows a frustum culled list down to the chunks reachable from the camera. The frustum is
+        // the one the list was culled with and bounds the walk through missing chunks
+        void Cull(Scene& scene, const glm::vec3& camera_pos, const Frustum& frustum, std::vector<VisibleChunk>& visible, CullingStats& stats);
+
+    private:
+        static constexpr i8 NO_FACE = -1;
+
+        struct Step {
+            glm::ivec3 position;
+            Chunk* chunk;   // Null for a missing chunk
+            i8 entry_face;  // Face of this chunk the walk came in through
+            u8 directions;  // Every face direction taken so far, one bit per Voxel::FaceIndex
+        };
+
+        u32 m_frame = 0;
+        std::vector<Step> m_queue;
+        std::unordered_set<glm::ivec3> m_visited_missing; // Missing chunks have no stamp to mark
+    };
+}
+
+#endif // OCCLUSION_CULLER_HPP
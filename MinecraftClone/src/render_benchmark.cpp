@@ -0,0 +1,116 @@
+#include "render_benchmark.hpp"
+#include "application.hpp"
+#include "gl_trace.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace MC {
+    namespace {
+        // The flight is driven by the frame index instead of the clock so every run renders the same views:
+        // a straight line over the terrain while the view sweeps from side to side
+        const glm::vec3 FLIGHT_START = glm::vec3(10.0f, 100.0f, 10.0f);
+        constexpr f32 FLIGHT_SPEED = 0.5f;        // Blocks per frame
+        constexpr f32 FLIGHT_YAW = -90.0f;
+        constexpr f32 FLIGHT_YAW_SWEEP = 60.0f;   // Degrees to either side
+        constexpr f32 FLIGHT_SWEEP_FRAMES = 600.0f;
+        constexpr f32 FLIGHT_PITCH = -15.0f;
+
+        struct FrameSample {
+            FrameTimings timings;
+            u64 cull_microseconds = 0;
+            u32 chunks_visible = 0;
+            u64 triangles = 0;
+        };
+
+        void PlaceCamera(Camera& camera, u32 flight_frame) {
+            glm::vec3 direction(std::cos(glm::radians(FLIGHT_YAW)), 0.0f, std::sin(glm::radians(FLIGHT_YAW)));
+            f32 sweep = std::sin(glm::two_pi<f32>() * flight_frame / FLIGHT_SWEEP_FRAMES);
+
+            camera.SetPosition(FLIGHT_START + direction * (FLIGHT_SPEED * flight_frame));
+            camera.SetRotation(FLIGHT_YAW + FLIGHT_YAW_SWEEP * sweep, FLIGHT_PITCH);
+        }
+
+        f64 Average(const std::vector<FrameSample>& samples, u64 FrameTimings::* stage) {
+            f64 total = 0.0;
+            for (const FrameSample& sample : samples) {
+                total += sample.timings.*stage;
+            }
+            return total / samples.size();
+        }
+
+        u64 Percentile(std::vector<u64> values, f64 percentile) {
+            size_t index = static_cast<size_t>(percentile * (values.size() - 1));
+            std::nth_element(values.begin(), values.begin() + index, values.end());
+            return values[index];
+        }
+
+        void WriteSamples(const std::string& path, const std::vector<FrameSample>& samples) {
+            std::ofstream file(path, std::ios::out | std::ios::trunc);
+            if (!file.is_open()) {
+                LOG_ERROR("Failed to open render benchmark output: " << path);
+                return;
+            }
+
+            file << "frame,update_functions_us,chunk_streaming_us,chunk_updates_us,present_us,render_us,cull_us,frame_us,chunks_visible,triangles\n";
+            for (size_t i = 0; i < samples.size(); ++i) {
+                const FrameSample& sample = samples[i];
+                const FrameTimings& timings = sample.timings;
+                file << i << ',' << timings.update_functions << ',' << timings.chunk_streaming << ',' << timings.chunk_updates << ','
+                    << timings.present << ',' << timings.render << ',' << sample.cull_microseconds << ',' << timings.frame << ','
+                    << sample.chunks_visible << ',' << sample.triangles << '\n';
+            }
+        }
+    }
+
+    void RunRenderBenchmark(const RenderBenchmarkSettings& settings) {
+        LOG_INFO("Render benchmark: " << settings.width << "x" << settings.height << " offscreen, "
+            << settings.warmup_frames << " warmup frames, " << settings.frames << " measured frames");
+
+        std::vector<FrameSample> samples;
+        samples.reserve(settings.frames);
+        u32 frame = 0;
+
+        Application app;
+        app.CreateWindow("Minecraft Clone render benchmark", settings.width, settings.height, WindowMode::HEADLESS)
+            .AddUpdateFunction([&](Application& app) {
+                    // Update functions run first in the frame, so the stats are those of the frame before
+                    if (frame > settings.warmup_frames && samples.size() < settings.frames) {
+                        const CullingStats& culling = app.GetRenderer().GetCullingStats();
+                        samples.push_back({ app.GetFrameTimings(), culling.cull_microseconds, culling.chunks_visible,
+                            GLTrace::GetLastFrameStats().triangles });
+                        if (samples.size() == settings.frames) {
+                            app.Shutdown();
+                        }
+                    }
+
+                    PlaceCamera(app.GetScene().GetCamera(), frame > settings.warmup_frames ? frame - settings.warmup_frames : 0);
+                    ++frame;
+                })
+            .Start();
+
+        if (samples.empty()) {
+            LOG_WARN("Render benchmark finished without measuring a frame");
+            return;
+        }
+
+        WriteSamples(settings.output_path, samples);
+
+        std::vector<u64> frame_times;
+        frame_times.reserve(samples.size());
+        for (const FrameSample& sample : samples) {
+            frame_times.push_back(sample.timings.frame);
+        }
+
+        LOG_INFO("Average stage times (us): update functions " << Average(samples, &FrameTimings::update_functions)
+            << ", chunk streaming " << Average(samples, &FrameTimings::chunk_streaming)
+            << ", chunk updates " << Average(samples, &FrameTimings::chunk_updates)
+            << ", present " << Average(samples, &FrameTimings::present)
+            << ", render " << Average(samples, &FrameTimings::render));
+        LOG_INFO("Frame time (us): average " << Average(samples, &FrameTimings::frame) << ", median " << Percentile(frame_times, 0.5)
+            << ", 99th percentile " << Percentile(frame_times, 0.99) << ", worst " << *std::max_element(frame_times.begin(), frame_times.end()));
+        LOG_INFO("Per-frame timings written to " << settings.output_path);
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef RENDER_BENCHMARK_HPP
+#define RENDER_BENCHMARK_HPP
+
+#include "types.hpp"
+#include <string>
+
+namespace MC {
+    struct RenderBenchmarkSettings {
+        i32 width = 1280;
+        i32 height = 720;
+        u32 warmup_frames = 300; // The camera holds still while the first chunks stream in
+        u32 frames = 1200;
+        std::string output_path = "render_benchmark.csv";
+    };
+
+    // Runs the normal application loop in a headless window along a fixed camera flight, then writes
+    // the per-stage CPU time of every frame to a CSV file and logs a summary. Needs no display or GPU
+    void RunRenderBenchmark(const RenderBenchmarkSettings& settings = {});
+}
+
+#endif // RENDER_BENCHMARK_HPP
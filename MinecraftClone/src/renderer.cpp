@@ -1,12 +1,26 @@
 #include "renderer.hpp"
+#include "gl_trace.hpp"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
 
 namespace MC {
     Renderer::Renderer()
         : m_lit_shader("src/lit.vert", "src/lit.frag"),
           m_unlit_shader("src/unlit.vert", "src/unlit.frag"),
 		  m_enable_lighting(true) {
+        m_lit_shader.BindUniformBlock("FrameData", FRAME_UNIFORM_BINDING);
+        m_unlit_shader.BindUniformBlock("FrameData", FRAME_UNIFORM_BINDING);
+
+        glGenBuffers(1, &m_frame_ubo);
+        GL::BindBuffer(GL_UNIFORM_BUFFER, m_frame_ubo);
+        GL::BufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+        GL::BindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    Renderer::~Renderer() {
+        GL::DeleteBuffer(m_frame_ubo);
     }
 
     void Renderer::EnableLighting(bool enable)
@@ -19,6 +33,22 @@ namespace MC {
         return m_enable_lighting;
     }
 
+    void Renderer::EnableOcclusionCulling(bool enable) {
+        m_enable_occlusion_culling = enable;
+    }
+
+    bool Renderer::IsOcclusionCullingEnabled() const {
+        return m_enable_occlusion_culling;
+    }
+
+    void Renderer::EnableHorizonCulling(bool enable) {
+        m_enable_horizon_culling = enable;
+    }
+
+    bool Renderer::IsHorizonCullingEnabled() const {
+        return m_enable_horizon_culling;
+    }
+
     void Renderer::Render(ThreadPool& tp, Scene& scene) {
 
         Camera& camera = scene.GetCamera();
@@ -30,11 +60,9 @@ namespace MC {
 
         Shader& current_shader = m_enable_lighting ? m_lit_shader : m_unlit_shader;
 
-        current_shader.Use();
-        current_shader.SetMat4("view", view);
-        current_shader.SetMat4("projection", projection);
-    	current_shader.SetVec3("viewPos", camera.GetPosition());
-
+        m_frame_uniforms.view = view;
+        m_frame_uniforms.projection = projection;
+        m_frame_uniforms.view_pos = glm::vec4(camera.GetPosition(), 1.0f);
 
         f32 time = glfwGetTime();
         f32 sun_angle = time * 0.01;
@@ -93,9 +121,9 @@ namespace MC {
                 sky_color = glm::mix(night_sky_color, sunset_sky_color, sun_height + 1.0f);
             }
 
-            m_lit_shader.SetVec3("lightDirection", light_direction);
-            m_lit_shader.SetVec3("lightColor", light_color);
-            m_lit_shader.SetVec3("ambientLightColor", ambient_light_color);
+            m_frame_uniforms.light_direction = glm::vec4(light_direction, 0.0f);
+            m_frame_uniforms.light_color = glm::vec4(light_color, 1.0f);
+            m_frame_uniforms.ambient_light_color = glm::vec4(ambient_light_color, 1.0f);
 
             scene.SetSkyColor(sky_color);
 
@@ -112,53 +140,266 @@ namespace MC {
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         }
 
+        // Everything both shaders need for the frame goes up in one upload
+        GL::BindBuffer(GL_UNIFORM_BUFFER, m_frame_ubo);
+        GL::BufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &m_frame_uniforms);
+        GL::BindBuffer(GL_UNIFORM_BUFFER, 0);
+        GL::BindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, m_frame_ubo);
+
+        current_shader.Use();
+
         camera_frustum.Update(view_proj);
 
-        auto& chunks = scene.GetChunks();
+        // Everything up to the draw call runs on the thread pool, only GL work stays on this thread.
+        // A still camera over an unchanged world reuses last frame's draw list as is
+        if (CullChunks(tp, scene, camera_frustum, view_proj)) {
+            BuildDrawCommands(tp, scene.GetRenderTable());
+        }
+
+        // Chunk vertices are offset per draw, the model matrix only matters for the sun
+        current_shader.SetMat4("model", glm::mat4(1.0f));
+        scene.GetMeshArena().Draw(m_draw_commands, m_chunk_offsets);
+
+        if (m_enable_lighting)
+        {
+            RenderSun(sun, light_direction);
+        }
+    }
+
+    bool Renderer::CullChunks(ThreadPool& tp, Scene& scene, const Frustum& frustum, const glm::mat4& view_proj) {
+        auto start = std::chrono::steady_clock::now();
 
-        for (auto& [chunk_pos, chunk] : chunks) {
-            glm::vec3 chunk_world_pos = glm::vec3(chunk_pos * Chunk::CHUNK_SIZE);
-            glm::vec3 chunk_min = chunk_world_pos;
-            glm::vec3 chunk_max = chunk_world_pos + glm::vec3(Chunk::CHUNK_SIZE);
+        Camera& camera = scene.GetCamera();
+        ChunkRegionGrid& region_grid = scene.GetRegionGrid();
+        const ChunkRenderTable& render_table = scene.GetRenderTable();
+        glm::vec3 camera_pos = camera.GetPosition();
+        glm::ivec3 camera_chunk = glm::floor(camera_pos / static_cast<f32>(Chunk::CHUNK_SIZE));
+
+        auto AngleBetween = [](const glm::vec3& a, const glm::vec3& b) {
+            return std::acos(glm::clamp(glm::dot(a, b), -1.0f, 1.0f));
+        };
+
+        // Looking straight up or down a yaw change barely moves the front vector, the right vector catches it
+        VisibilityCache& cache = m_visibility_cache;
+        f32 moved = glm::distance(camera_pos, cache.origin);
+        f32 turned = std::max(AngleBetween(camera.GetFront(), cache.front), AngleBetween(camera.GetRight(), cache.right));
+
+        bool update_frustum = !cache.valid || render_table.GetLayoutVersion() != cache.layout_version ||
+            camera.GetProjectionMatrix() != cache.projection || moved > VISIBILITY_REUSE_DISTANCE ||
+            turned > glm::radians(VISIBILITY_REUSE_ANGLE);
+        bool update_reachable = update_frustum || render_table.GetMeshVersion() != cache.mesh_version ||
+            camera_chunk != cache.camera_chunk || m_enable_occlusion_culling != cache.occlusion_culling;
+        bool update_visible = update_reachable || view_proj != cache.view_proj || m_enable_horizon_culling != cache.horizon_culling;
+
+        if (!update_visible) {
+            m_culling_stats.cull_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            return false;
+        }
 
-            // Skip chunks that are not visible
-            if (!camera_frustum.IsBoxVisible(chunk_min, chunk_max)) {
-                continue;
+        if (update_frustum) {
+            cache.origin = camera_pos;
+            cache.front = camera.GetFront();
+            cache.right = camera.GetRight();
+            cache.projection = camera.GetProjectionMatrix();
+            cache.layout_version = render_table.GetLayoutVersion();
+
+            // Culled against a wider frustum so small camera moves only need the narrowing below
+            Frustum& reuse_frustum = cache.reuse_frustum;
+            reuse_frustum.Update(BuildReuseViewProjection(camera));
+            region_grid.UpdateBounds();
+
+            // Each batch of regions culls into its own list, merged in batch order afterwards
+            size_t region_count = region_grid.GetRegions().size();
+            size_t batch_count = ThreadPool::GetBatchCount(region_count, ChunkRegionGrid::REGIONS_PER_BATCH);
+            m_batch_visible_chunks.resize(batch_count);
+            m_batch_culling_stats.resize(batch_count);
+
+            tp.ParallelFor(region_count, ChunkRegionGrid::REGIONS_PER_BATCH, [&](size_t batch, size_t first_region, size_t last_region) {
+                m_batch_visible_chunks[batch].clear();
+                m_batch_culling_stats[batch] = CullingStats{};
+                render_table.CullFrustum(reuse_frustum, region_grid, first_region, last_region, m_batch_visible_chunks[batch], m_batch_culling_stats[batch]);
+                });
+
+            m_frustum_chunks.clear();
+            m_frustum_stats = CullingStats{};
+            for (size_t batch = 0; batch < batch_count; ++batch) {
+                m_frustum_chunks.insert(m_frustum_chunks.end(), m_batch_visible_chunks[batch].begin(), m_batch_visible_chunks[batch].end());
+                m_frustum_stats.Merge(m_batch_culling_stats[batch]);
             }
+        }
 
-            if (!chunk->IsMeshDataUploaded()) {
-                continue; // Skip if mesh data is not ready
+        // The cave walk only depends on the camera's chunk, so it survives moves inside it. A wider
+        // frustum only ever lets it reach more chunks, never fewer
+        if (update_reachable) {
+            cache.camera_chunk = camera_chunk;
+            cache.mesh_version = render_table.GetMeshVersion();
+            cache.occlusion_culling = m_enable_occlusion_culling;
+
+            m_reachable_chunks = m_frustum_chunks;
+            m_reachable_stats = m_frustum_stats;
+            if (m_enable_occlusion_culling) {
+                m_occlusion_culler.Cull(scene, camera_pos, cache.reuse_frustum, m_reachable_chunks, m_reachable_stats);
             }
+        }
 
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), chunk_world_pos);
-            current_shader.SetMat4("model", model);
+        cache.view_proj = view_proj;
+        cache.horizon_culling = m_enable_horizon_culling;
+        cache.valid = true;
+
+        // Narrow the cached set down to this frame's frustum
+        const ChunkRenderRows& rows = render_table.GetRows();
+        m_visible_chunks.clear();
+        for (const VisibleChunk& visible_chunk : m_reachable_chunks) {
+            u32 row = visible_chunk.row;
+            glm::vec3 chunk_min(rows.min_x[row], rows.min_y[row], rows.min_z[row]);
+            glm::vec3 chunk_max(rows.max_x[row], rows.max_y[row], rows.max_z[row]);
+            if (frustum.IsBoxVisible(chunk_min, chunk_max)) {
+                m_visible_chunks.push_back(visible_chunk);
+            }
+        }
 
-            glBindVertexArray(chunk->GetVAO());
+        m_culling_stats = m_reachable_stats;
+        m_culling_stats.chunks_visible = static_cast<u32>(m_visible_chunks.size());
+
+        // The horizon sweep depends on the exact eye position and is cheap next to a full pass
+        if (m_enable_horizon_culling) {
+            m_horizon_culler.Cull(scene, camera_pos, m_visible_chunks, m_culling_stats);
+        }
+
+        SortFrontToBack(camera_pos);
+
+        m_culling_stats.cull_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
 
-            glDrawElements(GL_TRIANGLES, chunk->GetIndexCount(), GL_UNSIGNED_INT, 0);
+    glm::mat4 Renderer::BuildReuseViewProjection(const Camera& camera) const {
+        // Both half angles grow by twice the reuse angle, enough for a turn that moves the front and
+        // right vectors by up to the reuse angle each
+        f32 margin = glm::radians(VISIBILITY_REUSE_ANGLE) * 2.0f;
+        f32 max_half_angle = glm::radians(85.0f);
+        f32 half_fov_y = glm::radians(camera.GetFOV()) * 0.5f;
+        f32 half_fov_x = std::atan(std::tan(half_fov_y) * camera.GetAspectRatio());
+        f32 wide_half_fov_y = std::min(half_fov_y + margin, max_half_angle);
+        f32 wide_half_fov_x = std::min(half_fov_x + margin, max_half_angle);
+
+        // Pulling the apex back until every side plane is the reuse distance away from the camera
+        // covers the views from every position within that distance
+        f32 pullback = VISIBILITY_REUSE_DISTANCE / std::sin(std::min(wide_half_fov_x, wide_half_fov_y));
+        glm::vec3 apex = camera.GetPosition() - camera.GetFront() * pullback;
+
+        // A turned view reaches further along the old front than the far plane, up to its far corners
+        f32 far_corner = camera.GetFar() * std::sqrt(1.0f + std::tan(half_fov_x) * std::tan(half_fov_x) + std::tan(half_fov_y) * std::tan(half_fov_y));
+
+        glm::mat4 projection = glm::perspective(wide_half_fov_y * 2.0f, std::tan(wide_half_fov_x) / std::tan(wide_half_fov_y),
+            camera.GetNear(), far_corner + pullback + VISIBILITY_REUSE_DISTANCE);
+        return projection * glm::lookAt(apex, apex + camera.GetFront(), camera.GetUp());
+    }
 
-            glBindVertexArray(0);
+    void Renderer::BuildDrawCommands(ThreadPool& tp, const ChunkRenderTable& render_table) {
+        size_t chunk_count = m_visible_chunks.size();
+        size_t batch_count = ThreadPool::GetBatchCount(chunk_count, DRAW_CHUNKS_PER_BATCH);
+        m_batch_draw_commands.resize(batch_count);
+        m_batch_chunk_offsets.resize(batch_count);
+
+        const ChunkRenderRows& rows = render_table.GetRows();
+        tp.ParallelFor(chunk_count, DRAW_CHUNKS_PER_BATCH, [this, &rows](size_t batch, size_t first_chunk, size_t last_chunk) {
+            std::vector<DrawElementsIndirectCommand>& commands = m_batch_draw_commands[batch];
+            std::vector<glm::vec4>& offsets = m_batch_chunk_offsets[batch];
+            commands.clear();
+            offsets.clear();
+
+            for (size_t i = first_chunk; i < last_chunk; ++i) {
+                u32 row = m_visible_chunks[i].row;
+                if (!(rows.flags[row] & ChunkRenderTable::FLAG_HAS_MESH)) {
+                    continue; // Not uploaded yet or nothing but air
+                }
+
+                // base_instance is local to the batch until the merge below
+                commands.push_back({
+                    rows.index_count[row],
+                    1,
+                    rows.index_offset[row],
+                    static_cast<i32>(rows.vertex_offset[row]),
+                    static_cast<u32>(offsets.size())
+                });
+                offsets.emplace_back(rows.min_x[row], rows.min_y[row], rows.min_z[row], 0.0f);
+            }
+            });
+
+        // Batches stay in order, so the commands keep the front to back order the multi-draw consumes them in
+        m_draw_commands.clear();
+        m_chunk_offsets.clear();
+        for (size_t batch = 0; batch < batch_count; ++batch) {
+            // base_instance indexes the chunk offset for this draw
+            u32 first_instance = static_cast<u32>(m_chunk_offsets.size());
+            for (DrawElementsIndirectCommand command : m_batch_draw_commands[batch]) {
+                command.base_instance += first_instance;
+                m_draw_commands.push_back(command);
+            }
+            m_chunk_offsets.insert(m_chunk_offsets.end(), m_batch_chunk_offsets[batch].begin(), m_batch_chunk_offsets[batch].end());
         }
+    }
 
-        if (m_enable_lighting)
-        {
-            RenderSun(sun, camera, light_direction);
+    void Renderer::SortFrontToBack(const glm::vec3& camera_pos) {
+        size_t count = m_visible_chunks.size();
+        if (count < 2) {
+            return;
         }
+
+        m_chunk_distances.resize(count);
+        f32 max_distance = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 chunk_center = glm::vec3(m_visible_chunks[i].position * Chunk::CHUNK_SIZE) + glm::vec3(Chunk::CHUNK_SIZE * 0.5f);
+            m_chunk_distances[i] = glm::length(chunk_center - camera_pos);
+            max_distance = std::max(max_distance, m_chunk_distances[i]);
+        }
+
+        // 16 bit keys relative to the farthest chunk, far finer than the chunk size at any render distance
+        f32 key_scale = max_distance > 0.0f ? 65535.0f / max_distance : 0.0f;
+        m_sort_keys.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            m_sort_keys[i] = static_cast<u16>(m_chunk_distances[i] * key_scale);
+        }
+
+        m_sorted_chunks.resize(count);
+        m_sorted_keys.resize(count);
+
+        for (u32 shift = 0; shift < 16; shift += 8) {
+            std::array<u32, 257> offsets{};
+            for (u16 key : m_sort_keys) {
+                ++offsets[((key >> shift) & 0xFF) + 1];
+            }
+            for (size_t digit = 1; digit < offsets.size(); ++digit) {
+                offsets[digit] += offsets[digit - 1];
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                u32 destination = offsets[(m_sort_keys[i] >> shift) & 0xFF]++;
+                m_sorted_chunks[destination] = m_visible_chunks[i];
+                m_sorted_keys[destination] = m_sort_keys[i];
+            }
+
+            m_visible_chunks.swap(m_sorted_chunks);
+            m_sort_keys.swap(m_sorted_keys);
+        }
+    }
+
+    const CullingStats& Renderer::GetCullingStats() const {
+        return m_culling_stats;
     }
 
-    void Renderer::RenderSun(const Sun& sun, const Camera& camera, const glm::vec3& light_direction) {
+    void Renderer::RenderSun(const Sun& sun, const glm::vec3& light_direction) {
         glm::vec3 sun_position = light_direction * 2500.0f; // Position sun far away
         glm::mat4 model = glm::translate(glm::mat4(1.0f), sun_position);
         model = glm::scale(model, glm::vec3(150.0f)); // Scale the sun cube
 
+        // View and projection come from the frame uniform block
         m_unlit_shader.Use();
         m_unlit_shader.SetMat4("model", model);
-        m_unlit_shader.SetMat4("view", camera.GetViewMatrix());
-        m_unlit_shader.SetMat4("projection", camera.GetProjectionMatrix());
 
-        glBindVertexArray(sun.GetVAO());
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        GL::BindVertexArray(sun.GetVAO());
+        GL::DrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        GL::BindVertexArray(0);
     }
 
 }
@@ -3,28 +3,128 @@
 
 #include "scene.hpp"
 #include "shader.hpp"
+#include "occlusion_culler.hpp"
+#include "horizon_culler.hpp"
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <unordered_map>
 #include <array>
+#include <vector>
 
 namespace MC {
+    // Mirrors the std140 FrameData block shared by the chunk and sun shaders
+    struct FrameUniforms {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 view_pos;
+        glm::vec4 light_direction;
+        glm::vec4 light_color;
+        glm::vec4 ambient_light_color;
+    };
+
     class Renderer {
     public:
+        static constexpr u32 FRAME_UNIFORM_BINDING = 0;
+
+        // Draw command generation is split into batches of this many chunks on the thread pool
+        static constexpr size_t DRAW_CHUNKS_PER_BATCH = 4096;
+
+        // How far the camera may move (in blocks) and turn (in degrees) before the cached frustum
+        // and cave culling results are thrown away instead of narrowed down to the new view
+        static constexpr f32 VISIBILITY_REUSE_DISTANCE = 8.0f;
+        static constexpr f32 VISIBILITY_REUSE_ANGLE = 10.0f;
+
         Renderer();
-        ~Renderer() = default;
+        ~Renderer();
 
         void Render(ThreadPool& tp, Scene& scene);
-        void RenderSun(const Sun& sun, const Camera& camera, const glm::vec3& light_direction);
+        void RenderSun(const Sun& sun, const glm::vec3& light_direction);
 
         void EnableLighting(bool enable);
         bool IsLightingEnabled() const;
+
+        void EnableOcclusionCulling(bool enable);
+        bool IsOcclusionCullingEnabled() const;
+
+        void EnableHorizonCulling(bool enable);
+        bool IsHorizonCullingEnabled() const;
+
+        const CullingStats& GetCullingStats() const;
     public:
     private:
+        // What the cached visibility was computed from
+        struct VisibilityCache {
+            bool valid = false;
+
+            // Frustum stage
+            glm::vec3 origin = glm::vec3(0.0f);
+            glm::vec3 front = glm::vec3(0.0f);
+            glm::vec3 right = glm::vec3(0.0f);
+            glm::mat4 projection = glm::mat4(1.0f);
+            u64 layout_version = 0;
+            Frustum reuse_frustum;  // Wider than the view, what the frustum stage culled against
+
+            // Cave culling stage
+            glm::ivec3 camera_chunk = glm::ivec3(0);
+            u64 mesh_version = 0;
+            bool occlusion_culling = false;
+
+            // Final narrowing, horizon culling and sorting
+            glm::mat4 view_proj = glm::mat4(1.0f);
+            bool horizon_culling = false;
+        };
+
+        // Fills m_visible_chunks, whole regions are accepted or rejected before any chunk is tested
+        // and the survivors are then narrowed down to what the camera can see through the caves
+        // and over the terrain. Each stage reuses last frame's result while its inputs are unchanged,
+        // returns false when m_visible_chunks was left as it was
+        bool CullChunks(ThreadPool& tp, Scene& scene, const Frustum& frustum, const glm::mat4& view_proj);
+
+        // View projection of a frustum wide enough to hold the camera's view from anywhere within
+        // the reuse distance and angle
+        glm::mat4 BuildReuseViewProjection(const Camera& camera) const;
+
+        // Turns m_visible_chunks into indirect draw commands and per-draw chunk offsets
+        void BuildDrawCommands(ThreadPool& tp, const ChunkRenderTable& render_table);
+
+        // Orders m_visible_chunks nearest first so opaque geometry gets the most out of early depth
+        // rejection. Two 8 bit radix passes over the quantized distance keep it linear in the chunk count
+        void SortFrontToBack(const glm::vec3& camera_pos);
+
         // Normally I would not hardcode these but this is just a simple minecraft clone, nothing fancy
         Shader m_lit_shader;
         Shader m_unlit_shader;
         bool m_enable_lighting;
+
+        FrameUniforms m_frame_uniforms{};
+        u32 m_frame_ubo = 0;
+
+        OcclusionCuller m_occlusion_culler;
+        bool m_enable_occlusion_culling = true;
+        HorizonCuller m_horizon_culler;
+        bool m_enable_horizon_culling = true;
+        CullingStats m_culling_stats;
+
+        VisibilityCache m_visibility_cache;
+        std::vector<VisibleChunk> m_frustum_chunks;   // Inside the widened frustum
+        std::vector<VisibleChunk> m_reachable_chunks; // And reachable through the caves
+        CullingStats m_frustum_stats;
+        CullingStats m_reachable_stats;
+
+        // Rebuilt every frame, kept around to reuse their storage
+        std::vector<VisibleChunk> m_visible_chunks;
+        std::vector<VisibleChunk> m_sorted_chunks;
+        std::vector<f32> m_chunk_distances;
+        std::vector<u16> m_sort_keys;
+        std::vector<u16> m_sorted_keys;
+        std::vector<DrawElementsIndirectCommand> m_draw_commands;
+        std::vector<glm::vec4> m_chunk_offsets;
+
+        // Per-batch results of the parallel passes
+        std::vector<std::vector<VisibleChunk>> m_batch_visible_chunks;
+        std::vector<CullingStats> m_batch_culling_stats;
+        std::vector<std::vector<DrawElementsIndirectCommand>> m_batch_draw_commands;
+        std::vector<std::vector<glm::vec4>> m_batch_chunk_offsets;
     };
 }
 
@@ -1,5 +1,6 @@
 #include "scene.hpp"
 #include "ray.hpp"
+#include "world_gen_profiler.hpp"
 #include <FastNoise/FastNoise.h>
 #include <glm/gtc/noise.hpp>
 #include <cmath>
@@ -10,17 +11,40 @@
 namespace MC {
     // Constants for world generation
     const i32 CHUNK_LOAD_RADIUS = 32;
-    const i32 CHUNK_LOAD_HEIGHT = 4;
+    const i32 CHUNK_LOAD_HEIGHT = 4;   // Chunks below the player that load when they are under the terrain
+    const i32 CHUNK_LOAD_DEPTH = 3;    // Chunks below a column's lowest surface block that load
     const f32 BIOME_SCALE = 0.003f; // Larger scale for smaller biomes
     const f32 ELEVATION_SCALE = 0.05f; // Smaller scale for smoother terrain
     const f32 CAVE_SCALE = 0.05f;
     const f32 TREE_SCALE = 0.03f;
-    const f32 ORE_SCALE = 0.1f;
+    const i32 ELEVATION_OCTAVES = 6; // Increased for more detail
     const f32 CAVE_THRESHOLD = 0.6f;
     const f32 TREE_THRESHOLD = 0.8f;
     const i32 SEA_LEVEL = 60;
-    // Limit the number of chunks to generate per frame
-    const size_t MAX_CHUNKS_PER_FRAME = 2;
+    const i32 PROBE_CHUNK_Y = SEA_LEVEL / Chunk::CHUNK_SIZE; // Generated first in a column whose terrain is not known yet
+    const i32 LAVA_MAX_Y = 10;  // Lava pools only below this height
+    const i32 ORE_MIN_Y = 5;    // Ores only strictly between these heights
+    const i32 ORE_MAX_Y = 60;
+    const f32 LAVA_POOL_CHANCE = 0.3f; // Per chunk reaching below LAVA_MAX_Y
+    const i32 LAVA_POOL_MAX_RADIUS = 3;
+    const i32 TREE_MAX_HEIGHT = 11;     // Top leaves of the tallest tree over its column's terrain
+
+    // Ore veins placed per chunk, a vein whose origin lands outside its height range places nothing
+    struct OreVein {
+        VoxelType ore;
+        i32 veins_per_chunk;
+        i32 vein_size;  // Steps of the walk that grows the vein
+        i32 max_y;
+    };
+
+    const OreVein ORE_VEINS[] = {
+        { VoxelType::COAL_ORE, 8, 12, ORE_MAX_Y },
+        { VoxelType::IRON_ORE, 5, 8, ORE_MAX_Y },
+        { VoxelType::GOLD_ORE, 2, 6, 32 },
+        { VoxelType::DIAMOND_ORE, 1, 4, 16 },
+    };
+    // Added to the squared distance of chunks outside the frustum when ordering uploads
+    const f32 UPLOAD_OFFSCREEN_PRIORITY_PENALTY = 1.0e9f;
 
     f32 Hash(i32 x, i32 y, i32 z, uint32_t seed) {
         uint32_t h = seed;
@@ -37,6 +61,156 @@ namespace MC {
         return static_cast<f32>(h % 1000000) / 1000000.0f; // Normalize to [0,1)
     }
 
+    // Highest block of a column that may be something other than air, water, snow and ice reach past the terrain
+    i32 GetSurfaceTop(i32 terrain_height, BiomeType biome) {
+        i32 surface_top = terrain_height + 2;
+        if (biome == BiomeType::OCEAN) {
+            surface_top = std::max(surface_top, SEA_LEVEL);
+        }
+        return surface_top;
+    }
+
+    // The load radius is measured between columns, how far up or down a column loads depends on its terrain
+    f32 GetColumnDistance(const glm::ivec3& chunk_pos, const glm::ivec3& player_chunk_pos) {
+        return glm::length(glm::vec2(chunk_pos.x - player_chunk_pos.x, chunk_pos.z - player_chunk_pos.z));
+    }
+
+    // Chunk rows of one column worth loading
+    struct ChunkRowRange {
+        i32 min_y;
+        i32 max_y;
+    };
+
+    // From a few chunks under the column's lowest surface block, or under the player when they are deeper, up to
+    // the tallest tree over the highest surface block of the column and its neighbours, whose trees reach into it.
+    // Above that there is only air, below the bedrock nothing
+    ChunkRowRange GetColumnLoadRange(const std::unordered_map<glm::ivec2, ChunkColumnHeights>& columns, const glm::ivec2& column_pos,
+        i32 player_chunk_y) {
+        const ChunkColumnHeights& column = columns.at(column_pos);
+        i32 max_height = column.max_height;
+        for (i32 x = -1; x <= 1; ++x) {
+            for (i32 z = -1; z <= 1; ++z) {
+                auto neighbour_it = columns.find(column_pos + glm::ivec2(x, z));
+                if (neighbour_it != columns.end()) {
+                    max_height = std::max(max_height, neighbour_it->second.max_height);
+                }
+            }
+        }
+
+        i32 top = std::max(max_height + TREE_MAX_HEIGHT, SEA_LEVEL);
+        i32 min_y = std::min(column.min_height / Chunk::CHUNK_SIZE - CHUNK_LOAD_DEPTH, player_chunk_y - CHUNK_LOAD_HEIGHT);
+        return { std::max(min_y, 0), top / Chunk::CHUNK_SIZE };
+    }
+
+    // Structure voxels land in whatever order their trees are placed and their chunks are published, so every
+    // overlap, inside a chunk or across a border, is resolved by a fixed ranking instead: wood over leaves over
+    // everything else, ties by voxel type
+    void MergeStructureVoxel(Chunk& chunk, const glm::ivec3& local_pos, VoxelType voxel_type) {
+        auto rank = [](VoxelType type) {
+            u32 structure_rank = 0;
+            if (type == VoxelType::WOOD) {
+                structure_rank = 2;
+            }
+            else if (type == VoxelType::LEAVES || type == VoxelType::LEAVES_BIRCH || type == VoxelType::MANGROVE_LEAVES) {
+                structure_rank = 1;
+            }
+            return (structure_rank << 8) | static_cast<u32>(type);
+        };
+
+        if (rank(voxel_type) > rank(chunk.GetVoxel(local_pos))) {
+            chunk.SetVoxel(local_pos, voxel_type);
+        }
+    }
+
+    // Deterministic random numbers for placing the features of one chunk, the same for a given seed,
+    // chunk and feature no matter which thread generates the chunk or when
+    class FeatureRandom {
+    public:
+        FeatureRandom(const glm::ivec3& chunk_pos, u32 seed, u32 feature) {
+            m_state = Mix(seed ^ Mix(static_cast<u32>(chunk_pos.x) ^ Mix(static_cast<u32>(chunk_pos.y) ^ Mix(static_cast<u32>(chunk_pos.z) ^ Mix(feature)))));
+        }
+
+        u32 Next() {
+            m_state += 0x9e3779b9;
+            return Mix(m_state);
+        }
+
+        // In [0, bound)
+        i32 NextInt(i32 bound) {
+            return static_cast<i32>(Next() % static_cast<u32>(bound));
+        }
+
+        // In [0, 1)
+        f32 NextFloat() {
+            return static_cast<f32>(Next() >> 8) / 16777216.0f;
+        }
+
+    private:
+        static u32 Mix(u32 h) {
+            h ^= h >> 16;
+            h *= 0x85ebca6b;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35;
+            h ^= h >> 16;
+            return h;
+        }
+
+        u32 m_state;
+    };
+
+    // Water above the terrain, decided by the column alone so generation never reads other chunks
+    bool IsSurfaceWater(i32 world_y, i32 terrain_height, BiomeType biome) {
+        if (world_y <= terrain_height) {
+            return false;
+        }
+        if (biome == BiomeType::OCEAN && world_y <= SEA_LEVEL) {
+            return true;
+        }
+        return biome == BiomeType::SWAMP && world_y == terrain_height + 1;
+    }
+
+    // Terrain height of a biome as a linear function of the elevation noise, so neighbouring biomes blend by
+    // averaging their curves
+    struct BiomeElevationCurve {
+        f32 scale;
+        f32 offset;
+    };
+
+    BiomeElevationCurve GetBiomeElevationCurve(BiomeType biome) {
+        switch (biome) {
+        case BiomeType::PLAINS:
+            return { 10.0f, 50.0f };
+        case BiomeType::MOUNTAINS:
+            return { 40.0f, 80.0f };
+        case BiomeType::DESERT:
+            return { 5.0f, 45.0f };
+        case BiomeType::FOREST:
+            return { 15.0f, 55.0f };
+        case BiomeType::SWAMP:
+            return { 4.0f, 48.0f };
+        case BiomeType::JUNGLE:
+            return { 20.0f, 60.0f };
+        case BiomeType::SAVANNA:
+            return { 12.0f, 52.0f };
+        case BiomeType::TAIGA:
+            return { 18.0f, 58.0f };
+        case BiomeType::SNOWY_MOUNTAINS:
+            return { 50.0f, 90.0f };
+        case BiomeType::OCEAN:
+            return { -10.0f, static_cast<f32>(SEA_LEVEL) }; // Deeper oceans
+        case BiomeType::TUNDRA:
+            return { 8.0f, 55.0f };
+        case BiomeType::BIRCH_FOREST:
+            return { 15.0f, 55.0f };
+        case BiomeType::MANGROVE:
+            return { 12.0f, 50.0f };
+        case BiomeType::MESA:
+            return { 6.0f, 48.0f };
+        default:
+            return { 20.0f, 60.0f };
+        }
+    }
+
     // Helper function to convert world position to chunk and local positions
     void WorldToChunkLocal(const glm::ivec3& world_pos, glm::ivec3& chunk_pos, glm::ivec3& local_pos) {
         chunk_pos = glm::floor(glm::vec3(world_pos) / static_cast<f32>(Chunk::CHUNK_SIZE));
@@ -92,14 +266,6 @@ namespace MC {
         //m_tree_fractal->SetGain(0.5f);
         //m_tree_fractal->SetLacunarity(2.0f);
 
-        // Initialize Ore Noise
-        m_ore_generator = FastNoise::New<FastNoise::Perlin>();
-        m_ore_fractal = FastNoise::New<FastNoise::FractalFBm>();
-        m_ore_fractal->SetSource(m_ore_generator);
-        m_ore_fractal->SetOctaveCount(3);
-        //m_ore_fractal->SetGain(0.7f);
-        //m_ore_fractal->SetLacunarity(2.0f);
-
         // Initialize Temperature Noise
         m_temperature_generator = FastNoise::New<FastNoise::Perlin>();
         m_temperature_fractal = FastNoise::New<FastNoise::FractalFBm>();
@@ -118,85 +284,248 @@ namespace MC {
     }
 
     Scene::~Scene() {
-        Voxel::CleanupStaticBuffers();
+        // Generation and mesh jobs reference their chunk and the scene, let them finish first
+        for (auto& [chunk_pos, job] : m_generation_jobs) {
+            job.done.wait();
+        }
+        for (auto& [chunk_pos, chunk] : m_chunks) {
+            chunk->WaitForMeshGeneration();
+        }
+        for (auto& chunk : m_retired_chunks) {
+            chunk->WaitForMeshGeneration();
+        }
+
+        if (!IsHeadless()) {
+            Voxel::CleanupStaticBuffers();
+        }
     }
 
     void Scene::InitializeScene() {
+        LOG_INFO("World seed: " << m_seed);
         Voxel::InitializeStaticBuffers();
         m_sun.Initialize();
+        m_gl_resources = std::make_unique<GLResourceManager>();
+        m_mesh_arena = std::make_unique<ChunkMeshArena>(*m_gl_resources);
+        m_mesh_sink = m_mesh_arena.get();
         UpdateChunksAroundPlayer();
     }
 
+    void Scene::InitializeHeadlessScene() {
+        LOG_INFO("World seed: " << m_seed);
+        m_recording_sink = std::make_unique<RecordingMeshSink>();
+        m_mesh_sink = m_recording_sink.get();
+        UpdateChunksAroundPlayer();
+    }
+
+    bool Scene::IsHeadless() const {
+        return m_gl_resources == nullptr;
+    }
+
     void Scene::UpdateChunksAroundPlayer() {
-        std::lock_guard<std::mutex> lock(m_chunk_mutex);
         glm::vec3 player_pos = m_camera->GetPosition();
         glm::ivec3 player_chunk_pos = glm::floor(player_pos / static_cast<f32>(Chunk::CHUNK_SIZE));
 
         m_last_player_chunk_pos = player_chunk_pos;
 
-        // Store chunks to unload
-        std::vector<glm::ivec3> chunks_to_unload;
+        // Chunks are only added and removed on the main thread, the lock is held just while that happens
+        {
+            std::lock_guard<std::shared_mutex> lock(m_chunk_mutex);
+            PublishGeneratedChunks(player_chunk_pos);
+
+            // Store chunks to unload
+            std::vector<glm::ivec3> chunks_to_unload;
+
+            // Identify chunks to unload
+            for (const auto& [chunk_pos, chunk] : m_chunks) {
+                if (GetColumnDistance(chunk_pos, player_chunk_pos) > CHUNK_LOAD_RADIUS) {
+                    chunks_to_unload.push_back(chunk_pos);
+                }
+            }
 
-        // Identify chunks to unload
-        for (const auto& [chunk_pos, chunk] : m_chunks) {
-            if (glm::distance(glm::vec3(chunk_pos), glm::vec3(player_chunk_pos)) > CHUNK_LOAD_RADIUS) {
-                chunks_to_unload.push_back(chunk_pos);
+            // Unload chunks, a worker may still be meshing them so they are released later
+            for (const auto& chunk_pos : chunks_to_unload) {
+                auto chunk_it = m_chunks.find(chunk_pos);
+                m_region_grid.Remove(chunk_pos);
+                m_render_table.Remove(chunk_pos);
+                m_retired_chunks.push_back(std::move(chunk_it->second));
+                m_chunks.erase(chunk_it);
+                m_structure_writes.erase(chunk_pos);
+                ++m_streaming_stats.chunks_unloaded;
+            }
+        }
+
+        // Columns go out of range together with their chunks
+        for (auto it = m_column_heights.begin(); it != m_column_heights.end();) {
+            glm::ivec2 offset = it->first - glm::ivec2(player_chunk_pos.x, player_chunk_pos.z);
+            if (glm::length(glm::vec2(offset)) > CHUNK_LOAD_RADIUS) {
+                it = m_column_heights.erase(it);
+            }
+            else {
+                ++it;
             }
         }
 
-        // Unload chunks
-        for (const auto& chunk_pos : chunks_to_unload) {
-            m_chunks.erase(chunk_pos);
+        size_t free_jobs = m_generation_budget.max_jobs_in_flight > m_generation_jobs.size()
+            ? m_generation_budget.max_jobs_in_flight - m_generation_jobs.size() : 0;
+        if (free_jobs == 0) {
+            m_streaming_stats.generation_jobs = m_generation_jobs.size();
+            return;
         }
 
-        std::vector<glm::ivec3> chunks_to_load;
+        // Nearest first, chunks the camera faces away from count as further away
+        glm::vec3 front = m_camera->GetFront();
+        f32 behind_weight = m_generation_budget.behind_camera_weight;
+        std::vector<std::pair<f32, glm::ivec3>> chunks_to_load;
+
+        auto add_candidate = [&](const glm::ivec3& chunk_pos) {
+            if (m_chunks.contains(chunk_pos) || m_generation_jobs.contains(chunk_pos)) {
+                return;
+            }
+
+            glm::ivec3 offset = chunk_pos - player_chunk_pos;
+            f32 distance = glm::length(glm::vec3(offset));
+
+            f32 facing = distance > 0.0f ? glm::dot(glm::vec3(offset) / distance, front) : 1.0f;
+            f32 priority = distance * (1.0f + behind_weight * (1.0f - facing) * 0.5f);
+            chunks_to_load.emplace_back(priority, chunk_pos);
+            };
 
         for (i32 x = -CHUNK_LOAD_RADIUS; x <= CHUNK_LOAD_RADIUS; ++x) {
-            for (i32 y = -CHUNK_LOAD_HEIGHT; y <= CHUNK_LOAD_HEIGHT; ++y) {
-                for (i32 z = -CHUNK_LOAD_RADIUS; z <= CHUNK_LOAD_RADIUS; ++z) {
-                    glm::ivec3 offset(x, y, z);
-                    f32 distance = glm::length(glm::vec3(offset));
-                    if (distance > CHUNK_LOAD_RADIUS) {
-                        continue; // Skip chunks beyond the radius
-                    }
-                    glm::ivec3 chunk_pos = player_chunk_pos + offset;
-                    if (m_chunks.find(chunk_pos) == m_chunks.end()) {
-                        chunks_to_load.push_back(chunk_pos);
-                    }
+            for (i32 z = -CHUNK_LOAD_RADIUS; z <= CHUNK_LOAD_RADIUS; ++z) {
+                if (x * x + z * z > CHUNK_LOAD_RADIUS * CHUNK_LOAD_RADIUS) {
+                    continue; // Skip columns beyond the radius
+                }
+                glm::ivec2 column_pos(player_chunk_pos.x + x, player_chunk_pos.z + z);
+
+                // Until one of its chunks is generated the column's terrain is unknown, the chunk at sea level
+                // finds it out and is kept if it turns out to hold terrain
+                if (!m_column_heights.contains(column_pos)) {
+                    add_candidate(glm::ivec3(column_pos.x, PROBE_CHUNK_Y, column_pos.y));
+                    continue;
+                }
+
+                ChunkRowRange rows = GetColumnLoadRange(m_column_heights, column_pos, player_chunk_pos.y);
+                for (i32 y = rows.min_y; y <= rows.max_y; ++y) {
+                    add_candidate(glm::ivec3(column_pos.x, y, column_pos.y));
                 }
             }
         }
 
-        // Sort chunks_to_load based on distance
-        std::sort(chunks_to_load.begin(), chunks_to_load.end(), [player_chunk_pos](const glm::ivec3& a, const glm::ivec3& b) {
-            return glm::length(glm::vec3(a - player_chunk_pos)) < glm::length(glm::vec3(b - player_chunk_pos));
+        // Only the chunks that get a job this frame need to be in order
+        size_t job_count = std::min(free_jobs, chunks_to_load.size());
+        auto by_priority = [](const std::pair<f32, glm::ivec3>& a, const std::pair<f32, glm::ivec3>& b) {
+            return a.first < b.first;
+            };
+        std::partial_sort(chunks_to_load.begin(), chunks_to_load.begin() + job_count, chunks_to_load.end(), by_priority);
+
+        for (size_t i = 0; i < job_count; ++i) {
+            StartChunkGeneration(chunks_to_load[i].second);
+        }
+        m_streaming_stats.generation_jobs = m_generation_jobs.size();
+    }
+
+    void Scene::StartChunkGeneration(const glm::ivec3& chunk_pos) {
+        ChunkGenerationJob& job = m_generation_jobs[chunk_pos];
+        job.chunk = std::make_shared<Chunk>(chunk_pos);
+
+        // The map never moves its entries, the job owns them until the main thread sees it finished
+        Chunk* chunk = job.chunk.get();
+        std::vector<i32>* terrain_heights = &job.terrain_heights;
+        std::vector<StructureWrite>* structure_writes = &job.structure_writes;
+        job.done = m_thread_pool.Enqueue(TaskPriority::NORMAL, false, [this, chunk, terrain_heights, structure_writes]() {
+            GenerateVoxelDataForChunk(*chunk, *terrain_heights, *structure_writes);
             });
+    }
 
-        size_t chunks_loaded = 0;
+    void Scene::PublishGeneratedChunks(const glm::ivec3& player_chunk_pos) {
+        for (auto it = m_generation_jobs.begin(); it != m_generation_jobs.end();) {
+            ChunkGenerationJob& job = it->second;
+            if (job.done.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++it;
+                continue;
+            }
 
-        for (const auto& chunk_pos : chunks_to_load) {
-            if (chunks_loaded >= MAX_CHUNKS_PER_FRAME) {
-                break;
+            // Out of range by now, or created by a voxel edit while it was generating
+            glm::ivec3 chunk_pos = it->first;
+            if (GetColumnDistance(chunk_pos, player_chunk_pos) > CHUNK_LOAD_RADIUS || m_chunks.contains(chunk_pos)) {
+                ++m_streaming_stats.chunks_discarded;
+                it = m_generation_jobs.erase(it);
+                continue;
             }
-            GenerateChunk(chunk_pos);
-            ++chunks_loaded;
+
+            // The column's heights are known from here on, a sea level chunk above or below its terrain is not kept
+            RecordColumnHeights(chunk_pos, job.terrain_heights);
+            ChunkRowRange rows = GetColumnLoadRange(m_column_heights, glm::ivec2(chunk_pos.x, chunk_pos.z), player_chunk_pos.y);
+            if (chunk_pos.y < rows.min_y || chunk_pos.y > rows.max_y) {
+                ++m_streaming_stats.chunks_discarded;
+                it = m_generation_jobs.erase(it);
+                continue;
+            }
+
+            PublishChunk(chunk_pos, job);
+            it = m_generation_jobs.erase(it);
         }
     }
 
-    void Scene::GenerateChunk(const glm::ivec3& chunk_pos) {
-        auto new_chunk = std::make_shared<Chunk>(chunk_pos);
-        m_chunks.emplace(chunk_pos, new_chunk);
+    void Scene::PublishChunk(const glm::ivec3& chunk_pos, ChunkGenerationJob& job) {
+        // Structures of loaded neighbours that reach into this chunk, every time it is published
+        for (i32 x = -1; x <= 1; ++x) {
+            for (i32 y = -1; y <= 1; ++y) {
+                for (i32 z = -1; z <= 1; ++z) {
+                    auto writes_it = m_structure_writes.find(chunk_pos + glm::ivec3(x, y, z));
+                    if (writes_it == m_structure_writes.end()) {
+                        continue;
+                    }
+                    for (const StructureWrite& write : writes_it->second) {
+                        glm::ivec3 write_chunk_pos, local_pos;
+                        WorldToChunkLocal(write.world_pos, write_chunk_pos, local_pos);
+                        if (write_chunk_pos == chunk_pos) {
+                            MergeStructureVoxel(*job.chunk, local_pos, write.voxel_type);
+                        }
+                    }
+                }
+            }
+        }
 
-        GenerateVoxelDataForChunk(*new_chunk);
-        new_chunk->SetNeedsMeshUpdate(true);
+        m_chunks.emplace(chunk_pos, job.chunk);
+        u32 region = m_region_grid.Add(chunk_pos);
+        m_render_table.Add(chunk_pos, job.chunk.get(), region);
+        RecordColumnHeights(chunk_pos, job.terrain_heights);
+        ApplyStructureWrites(job.structure_writes);
+        m_structure_writes[chunk_pos] = std::move(job.structure_writes);
+        job.chunk->SetNeedsMeshUpdate(true);
+        ++m_streaming_stats.chunks_loaded;
     }
 
-    BiomeType Scene::GetBiomeType(i32 world_x, i32 world_z) {
-        // Generate temperature and humidity values
-        f32 temperature = m_temperature_fractal->GenSingle2D(world_x * BIOME_SCALE, world_z * BIOME_SCALE, m_seed + 6);
-        temperature = (temperature + 1.0f) / 2.0f; // Normalize to [0,1]
+    void Scene::GenerateRegion(const glm::ivec3& min_chunk_pos, const glm::ivec3& max_chunk_pos) {
+        for (i32 x = min_chunk_pos.x; x <= max_chunk_pos.x; ++x) {
+            for (i32 y = min_chunk_pos.y; y <= max_chunk_pos.y; ++y) {
+                for (i32 z = min_chunk_pos.z; z <= max_chunk_pos.z; ++z) {
+                    glm::ivec3 chunk_pos(x, y, z);
+                    if (!m_chunks.contains(chunk_pos) && !m_generation_jobs.contains(chunk_pos)) {
+                        StartChunkGeneration(chunk_pos);
+                    }
+                }
+            }
+        }
 
-        f32 humidity = m_humidity_fractal->GenSingle2D(world_x * BIOME_SCALE, world_z * BIOME_SCALE, m_seed + 7);
+        for (auto& [chunk_pos, job] : m_generation_jobs) {
+            job.done.wait();
+        }
+
+        // Publishing order does not change the result, overlapping structure voxels merge the same either way
+        std::lock_guard<std::shared_mutex> lock(m_chunk_mutex);
+        for (auto& [chunk_pos, job] : m_generation_jobs) {
+            if (!m_chunks.contains(chunk_pos)) {
+                PublishChunk(chunk_pos, job);
+            }
+        }
+        m_generation_jobs.clear();
+        m_streaming_stats.generation_jobs = 0;
+    }
+
+    BiomeType Scene::GetBiomeType(f32 temperature, f32 humidity) const {
+        temperature = (temperature + 1.0f) / 2.0f; // Normalize to [0,1]
         humidity = (humidity + 1.0f) / 2.0f; // Normalize to [0,1]
 
         // Determine biome based on temperature and humidity
@@ -231,66 +560,109 @@ namespace MC {
     }
 
     i32 Scene::GetBiomeElevation(f32 elevation, BiomeType biome) {
-        switch (biome) {
-        case BiomeType::PLAINS:
-            return static_cast<i32>(elevation * 10 + 50);
-        case BiomeType::MOUNTAINS:
-            return static_cast<i32>(elevation * 40 + 80);
-        case BiomeType::DESERT:
-            return static_cast<i32>(elevation * 5 + 45);
-        case BiomeType::FOREST:
-            return static_cast<i32>(elevation * 15 + 55);
-        case BiomeType::SWAMP:
-            return static_cast<i32>(elevation * 4 + 48);
-        case BiomeType::JUNGLE:
-            return static_cast<i32>(elevation * 20 + 60);
-        case BiomeType::SAVANNA:
-            return static_cast<i32>(elevation * 12 + 52);
-        case BiomeType::TAIGA:
-            return static_cast<i32>(elevation * 18 + 58);
-        case BiomeType::SNOWY_MOUNTAINS:
-            return static_cast<i32>(elevation * 50 + 90);
-        case BiomeType::OCEAN:
-            return SEA_LEVEL - static_cast<i32>(elevation * 10); // Deeper oceans
-        case BiomeType::TUNDRA:
-            return static_cast<i32>(elevation * 8 + 55);
-        case BiomeType::BIRCH_FOREST:
-            return static_cast<i32>(elevation * 15 + 55);
-        case BiomeType::MANGROVE:
-            return static_cast<i32>(elevation * 12 + 50);
-        case BiomeType::MESA:
-            return static_cast<i32>(elevation * 6 + 48);
-        default:
-            return static_cast<i32>(elevation * 20 + 60);
+        BiomeElevationCurve curve = GetBiomeElevationCurve(biome);
+        return static_cast<i32>(elevation * curve.scale + curve.offset);
+    }
+
+    void Scene::ComputeBiomes(const glm::ivec3& chunk_pos, ChunkNoiseFields& fields) {
+        const i32 cell_size = ChunkNoiseFields::BIOME_CELL_SIZE;
+        const i32 coarse_size = ChunkNoiseFields::BIOME_COARSE_SIZE;
+        const i32 grid_size = ChunkNoiseFields::BIOME_GRID_SIZE;
+        glm::ivec3 world_origin = chunk_pos * Chunk::CHUNK_SIZE;
+
+        // Scaling the frequency by the cell size samples every cell_size-th block of the full resolution noise
+        i32 coarse_x = world_origin.x / cell_size - 1;
+        i32 coarse_z = world_origin.z / cell_size - 1;
+        m_temperature_fractal->GenUniformGrid2D(fields.temperature.data(), coarse_x, coarse_z,
+            coarse_size, coarse_size, BIOME_SCALE * cell_size, m_seed + 6);
+        m_humidity_fractal->GenUniformGrid2D(fields.humidity.data(), coarse_x, coarse_z,
+            coarse_size, coarse_size, BIOME_SCALE * cell_size, m_seed + 7);
+
+        // Upsample bilinearly, the noise barely changes within a cell so the biomes match full resolution sampling.
+        // Grid column 0 is one block before the chunk, coarse sample 0 one cell before it
+        for (i32 grid_z = 0; grid_z < grid_size; ++grid_z) {
+            f32 coarse_pos_z = static_cast<f32>(grid_z - 1 + cell_size) / cell_size;
+            i32 z0 = static_cast<i32>(coarse_pos_z);
+            f32 tz = coarse_pos_z - z0;
+
+            for (i32 grid_x = 0; grid_x < grid_size; ++grid_x) {
+                f32 coarse_pos_x = static_cast<f32>(grid_x - 1 + cell_size) / cell_size;
+                i32 x0 = static_cast<i32>(coarse_pos_x);
+                f32 tx = coarse_pos_x - x0;
+
+                auto sample = [&](const auto& field) {
+                    f32 near_row = glm::mix(field[z0 * coarse_size + x0], field[z0 * coarse_size + x0 + 1], tx);
+                    f32 far_row = glm::mix(field[(z0 + 1) * coarse_size + x0], field[(z0 + 1) * coarse_size + x0 + 1], tx);
+                    return glm::mix(near_row, far_row, tz);
+                };
+                fields.biomes[grid_z * grid_size + grid_x] = GetBiomeType(sample(fields.temperature), sample(fields.humidity));
+            }
+        }
+
+        // Box filter the biome elevation curves over the 3x3 columns around each column, along x first
+        for (i32 grid_z = 0; grid_z < grid_size; ++grid_z) {
+            for (i32 x = 0; x < Chunk::CHUNK_SIZE; ++x) {
+                f32 scale = 0.0f;
+                f32 offset = 0.0f;
+                for (i32 dx = 0; dx < 3; ++dx) {
+                    BiomeElevationCurve curve = GetBiomeElevationCurve(fields.biomes[grid_z * grid_size + x + dx]);
+                    scale += curve.scale;
+                    offset += curve.offset;
+                }
+                fields.row_height_scale[grid_z * Chunk::CHUNK_SIZE + x] = scale;
+                fields.row_height_offset[grid_z * Chunk::CHUNK_SIZE + x] = offset;
+            }
+        }
+
+        // Then along z over the row sums
+        for (i32 z = 0; z < Chunk::CHUNK_SIZE; ++z) {
+            for (i32 x = 0; x < Chunk::CHUNK_SIZE; ++x) {
+                f32 scale = 0.0f;
+                f32 offset = 0.0f;
+                for (i32 dz = 0; dz < 3; ++dz) {
+                    scale += fields.row_height_scale[(z + dz) * Chunk::CHUNK_SIZE + x];
+                    offset += fields.row_height_offset[(z + dz) * Chunk::CHUNK_SIZE + x];
+                }
+                fields.height_scale[z * Chunk::CHUNK_SIZE + x] = scale / 9.0f;
+                fields.height_offset[z * Chunk::CHUNK_SIZE + x] = offset / 9.0f;
+            }
         }
     }
 
-    f32 Scene::ComputeElevationNoise(f32 x, f32 z) {
+    void Scene::ComputeElevationNoise(const glm::ivec3& chunk_pos, ChunkNoiseFields& fields) {
         // Minecraft-like elevation noise parameters
-        const i32 OCTAVES = 6; // Increased for more detail
+        const i32 OCTAVES = ELEVATION_OCTAVES;
         const f32 PERSISTENCE = 0.4f; // Lower persistence for smoother terrain
         const f32 LACUNARITY = 2.2f; // Higher lacunarity for more frequency variation
         f32 frequency = ELEVATION_SCALE;
         f32 amplitude = 1.0f;
         f32 max_amplitude = 0.0f;
-        f32 noise_value = 0.0f;
 
+        fields.elevation.fill(0.0f);
         for (i32 i = 0; i < OCTAVES; ++i) {
-            // Generate noise using FastNoise
-            f32 noise = m_elevation_fractal->GenSingle2D(x * frequency, z * frequency, m_seed + 1) * amplitude;
-            noise_value += noise;
+            // One grid of the fractal per octave, at the octave's frequency
+            m_elevation_fractal->GenUniformGrid2D(fields.elevation_octave.data(), chunk_pos.x * Chunk::CHUNK_SIZE, chunk_pos.z * Chunk::CHUNK_SIZE,
+                Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE, frequency, m_seed + 1);
+            for (size_t column = 0; column < ChunkNoiseFields::COLUMN_COUNT; ++column) {
+                fields.elevation[column] += fields.elevation_octave[column] * amplitude;
+            }
             max_amplitude += amplitude;
 
             amplitude *= PERSISTENCE;
             frequency *= LACUNARITY;
         }
 
-        noise_value /= max_amplitude; // Normalize
-        return (noise_value + 1.0f) / 2.0f; // Map to [0, 1]
+        for (f32& elevation : fields.elevation) {
+            elevation /= max_amplitude; // Normalize
+            elevation = (elevation + 1.0f) / 2.0f; // Map to [0, 1]
+        }
     }
 
-    i32 Scene::GetTerrainHeight(i32 world_x, i32 world_z, BiomeType biome) {
-        f32 elevation = ComputeElevationNoise(static_cast<f32>(world_x), static_cast<f32>(world_z));
+    i32 Scene::GetTerrainHeight(const ChunkNoiseFields& fields, i32 x, i32 z) {
+        // The biome grid starts one column before the chunk
+        size_t column = z * Chunk::CHUNK_SIZE + x;
+        BiomeType biome = fields.biomes[(z + 1) * ChunkNoiseFields::BIOME_GRID_SIZE + x + 1];
+        f32 elevation = fields.elevation[column];
 
         // Adjust elevation based on biome
         switch (biome) {
@@ -316,47 +688,15 @@ namespace MC {
             elevation *= 1.0f;
         }
 
-        // Get neighboring biome types and elevations
-        struct Neighbor {
-            BiomeType biome;
-            i32 height;
-        };
-
-        std::vector<Neighbor> neighbors = {
-            { biome, GetBiomeElevation(elevation, biome) },
-            { GetBiomeType(world_x + 1, world_z), GetBiomeElevation(elevation, GetBiomeType(world_x + 1, world_z)) },
-            { GetBiomeType(world_x - 1, world_z), GetBiomeElevation(elevation, GetBiomeType(world_x - 1, world_z)) },
-            { GetBiomeType(world_x, world_z + 1), GetBiomeElevation(elevation, GetBiomeType(world_x, world_z + 1)) },
-            { GetBiomeType(world_x, world_z - 1), GetBiomeElevation(elevation, GetBiomeType(world_x, world_z - 1)) },
-        };
-
-        // Calculate weights based on biome similarity (e.g., same biome gets higher weight)
-        f32 total_weight = 0.0f;
-        f32 blended_height = 0.0f;
-
-        for (const auto& neighbor : neighbors) {
-            f32 weight = (neighbor.biome == biome) ? 2.0f : 1.0f;
-            blended_height += neighbor.height * weight;
-            total_weight += weight;
-        }
-
-        blended_height /= total_weight;
-
-        return static_cast<i32>(blended_height);
-    }
-
-    bool Scene::IsCave(i32 world_x, i32 world_y, i32 world_z) {
-        f32 cave_noise = m_cave_fractal->GenSingle3D(world_x * CAVE_SCALE, world_y * CAVE_SCALE, world_z * CAVE_SCALE, m_seed + 3);
-        return cave_noise > CAVE_THRESHOLD;
+        // The elevation curves of the surrounding biomes are already blended
+        return static_cast<i32>(elevation * fields.height_scale[column] + fields.height_offset[column]);
     }
 
-    VoxelType Scene::GetVoxelType(i32 world_x, i32 world_y, i32 world_z, i32 terrain_height, BiomeType biome) {
+    VoxelType Scene::GetVoxelType(i32 world_y, i32 terrain_height, BiomeType biome,
+        const ChunkNoiseFields& fields, size_t column, size_t voxel) {
         // Above terrain height
         if (world_y > terrain_height) {
-            if (biome == BiomeType::OCEAN && world_y <= SEA_LEVEL) {
-                return VoxelType::WATER;
-            }
-            if (biome == BiomeType::SWAMP && world_y == terrain_height + 1) {
+            if (IsSurfaceWater(world_y, terrain_height, biome)) {
                 return VoxelType::WATER;
             }
             // Snow on top of snowy mountains
@@ -366,8 +706,7 @@ namespace MC {
             // Ice near water bodies in cold biomes
             if ((biome == BiomeType::SNOWY_MOUNTAINS || biome == BiomeType::TAIGA || biome == BiomeType::TUNDRA) && world_y <= terrain_height + 2) {
                 // Check if the voxel below is water
-                VoxelType below_voxel = GetVoxelAtPosition({ world_x, world_y - 1, world_z });
-                if (below_voxel == VoxelType::WATER) {
+                if (IsSurfaceWater(world_y - 1, terrain_height, biome)) {
                     return VoxelType::ICE;
                 }
             }
@@ -375,7 +714,7 @@ namespace MC {
         }
 
         // Check for caves
-        if (world_y < terrain_height && IsCave(world_x, world_y, world_z)) {
+        if (world_y < terrain_height && fields.has_caves && fields.cave[voxel] > CAVE_THRESHOLD) {
             return VoxelType::AIR;
         }
 
@@ -384,38 +723,10 @@ namespace MC {
             return VoxelType::BEDROCK;
         }
 
-        // Handle lava pools
-        if (world_y < 10) { // Arbitrary threshold for lava depth
-            f32 lava_noise = m_ore_fractal->GenSingle3D(world_x * ORE_SCALE, world_y * ORE_SCALE, world_z * ORE_SCALE, m_seed + 8);
-            lava_noise = (lava_noise + 1.0f) / 2.0f; // Normalize to [0,1]
-            if (lava_noise > 0.98f) { // Adjust threshold as needed
-                return VoxelType::LAVA;
-            }
-        }
-
-        // Generate ores
-        if (world_y < 60 && world_y > 5) {
-            f32 ore_noise = m_ore_fractal->GenSingle3D(world_x * ORE_SCALE, world_y * ORE_SCALE, world_z * ORE_SCALE, m_seed + 4);
-            ore_noise = (ore_noise + 1.0f) / 2.0f;
-            if (ore_noise > 0.96f) {
-                return VoxelType::DIAMOND_ORE;
-            }
-            else if (ore_noise > 0.92f) {
-                return VoxelType::GOLD_ORE;
-            }
-            else if (ore_noise > 0.88f) {
-                return VoxelType::IRON_ORE;
-            }
-            else if (ore_noise > 0.84f) {
-                return VoxelType::COAL_ORE;
-            }
-        }
-
         // Generate gravel in specific biomes or conditions
         if (biome == BiomeType::DESERT || biome == BiomeType::SAVANNA || biome == BiomeType::MESA) {
-            f32 gravel_noise = m_biome_fractal->GenSingle2D(world_x * BIOME_SCALE, world_z * BIOME_SCALE, m_seed + 9);
-            gravel_noise = (gravel_noise + 1.0f) / 2.0f;
-            if (gravel_noise > 0.95f && world_y <= GetBiomeElevation(ComputeElevationNoise(static_cast<f32>(world_x), static_cast<f32>(world_z)), biome)) {
+            f32 gravel_noise = (fields.gravel[column] + 1.0f) / 2.0f;
+            if (gravel_noise > 0.95f && world_y <= GetBiomeElevation(fields.elevation[column], biome)) {
                 return VoxelType::GRAVEL;
             }
         }
@@ -469,8 +780,8 @@ namespace MC {
         }
     }
 
-    void Scene::GenerateTrees(Chunk& chunk, i32 world_x, i32 world_z, i32 terrain_height, BiomeType biome) {
-        f32 tree_noise = m_tree_fractal->GenSingle2D(world_x * TREE_SCALE, world_z * TREE_SCALE, m_seed + 5);
+    void Scene::GenerateTrees(Chunk& chunk, i32 world_x, i32 world_z, i32 terrain_height, BiomeType biome, f32 tree_noise,
+        std::vector<StructureWrite>& structure_writes) {
         tree_noise = (tree_noise + 1.0f) / 2.0f;
 
         if (tree_noise > TREE_THRESHOLD) {
@@ -497,16 +808,10 @@ namespace MC {
                 break;
             }
 
-            // Ensure trees don't exceed chunk boundaries
+            // Trunk and leaves may reach into the neighbouring chunks
             i32 world_y = terrain_height + 1;
             for (i32 y = 0; y < trunk_height; ++y) {
-                if (world_y + y >= CHUNK_LOAD_HEIGHT * Chunk::CHUNK_SIZE) break;
-                glm::ivec3 local_pos = glm::ivec3(
-                    (world_x % Chunk::CHUNK_SIZE + Chunk::CHUNK_SIZE) % Chunk::CHUNK_SIZE,
-                    (world_y + y) % Chunk::CHUNK_SIZE,
-                    (world_z % Chunk::CHUNK_SIZE + Chunk::CHUNK_SIZE) % Chunk::CHUNK_SIZE
-                );
-                chunk.SetVoxel(local_pos, VoxelType::WOOD);
+                PlaceStructureVoxel(chunk, glm::ivec3(world_x, world_y + y, world_z), VoxelType::WOOD, structure_writes);
             }
 
             // Add leaves with better distribution
@@ -515,13 +820,6 @@ namespace MC {
                 for (i32 dx = -2; dx <= 2; ++dx) {
                     for (i32 dz = -2; dz <= 2; ++dz) {
                         if (dx * dx + dz * dz <= 4) {
-                            i32 world_leaf_x = world_x + dx;
-                            i32 world_leaf_z = world_z + dz;
-                            glm::ivec3 local_pos = glm::ivec3(
-                                (world_leaf_x % Chunk::CHUNK_SIZE + Chunk::CHUNK_SIZE) % Chunk::CHUNK_SIZE,
-                                y % Chunk::CHUNK_SIZE,
-                                (world_leaf_z % Chunk::CHUNK_SIZE + Chunk::CHUNK_SIZE) % Chunk::CHUNK_SIZE
-                            );
                             VoxelType leaf_type = VoxelType::LEAVES;
 
                             // Adjust leaf type based on biome
@@ -542,7 +840,7 @@ namespace MC {
                                 break;
                             }
 
-                            chunk.SetVoxel(local_pos, leaf_type);
+                            PlaceStructureVoxel(chunk, glm::ivec3(world_x + dx, y, world_z + dz), leaf_type, structure_writes);
                         }
                     }
                 }
@@ -550,55 +848,295 @@ namespace MC {
         }
     }
 
-    void Scene::GenerateVoxelDataForChunk(Chunk& chunk) {
+    void Scene::PlaceStructureVoxel(Chunk& chunk, const glm::ivec3& world_pos, VoxelType voxel_type, std::vector<StructureWrite>& structure_writes) {
+        glm::ivec3 local_pos = world_pos - chunk.GetPosition() * Chunk::CHUNK_SIZE;
+        bool inside = glm::all(glm::greaterThanEqual(local_pos, glm::ivec3(0))) && glm::all(glm::lessThan(local_pos, glm::ivec3(Chunk::CHUNK_SIZE)));
+        if (inside) {
+            MergeStructureVoxel(chunk, local_pos, voxel_type);
+        }
+        else {
+            structure_writes.push_back({ world_pos, voxel_type });
+        }
+    }
+
+    void Scene::ApplyStructureWrites(const std::vector<StructureWrite>& structure_writes) {
+        for (const StructureWrite& write : structure_writes) {
+            glm::ivec3 chunk_pos, local_pos;
+            WorldToChunkLocal(write.world_pos, chunk_pos, local_pos);
+
+            // A loaded chunk takes the write now and is remeshed once with everything written to it this frame,
+            // any other one reads it from the writing chunk when it is published
+            auto chunk_it = m_chunks.find(chunk_pos);
+            if (chunk_it != m_chunks.end()) {
+                MergeStructureVoxel(*chunk_it->second, local_pos, write.voxel_type);
+            }
+        }
+    }
+
+    void Scene::GenerateVoxelDataForChunk(Chunk& chunk, std::vector<i32>& terrain_heights, std::vector<StructureWrite>& structure_writes) {
         glm::ivec3 chunk_pos = chunk.GetPosition();
+        glm::ivec3 world_origin = chunk_pos * Chunk::CHUNK_SIZE;
+        const i32 biome_grid_size = ChunkNoiseFields::BIOME_GRID_SIZE;
+        const size_t column_count = ChunkNoiseFields::COLUMN_COUNT;
+
+        WorldGenChunkScope chunk_scope;
+        ChunkGenProfile& profile = chunk_scope.GetProfile();
 
-        std::vector<BiomeType> biome_types(Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE);
-        std::vector<i32> terrain_heights(Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE);
+        // Too big for the stack, reused by every chunk generated on the same thread
+        static thread_local ChunkNoiseFields fields;
+
+        // Column noise first, the terrain heights decide which voxel fields are needed at all
+        {
+            const size_t coarse_count = ChunkNoiseFields::BIOME_COARSE_SIZE * ChunkNoiseFields::BIOME_COARSE_SIZE;
+            WorldGenStageScope stage(profile, WorldGenStage::BIOMES, 2 * coarse_count);
+            ComputeBiomes(chunk_pos, fields);
+        }
+        {
+            WorldGenStageScope stage(profile, WorldGenStage::ELEVATION, ELEVATION_OCTAVES * column_count);
+            ComputeElevationNoise(chunk_pos, fields);
+        }
+
+        std::vector<BiomeType> biome_types(column_count);
+        terrain_heights.assign(column_count, 0);
+        i32 min_terrain_height = std::numeric_limits<i32>::max();
+        i32 max_terrain_height = std::numeric_limits<i32>::min();
+        i32 max_surface_top = std::numeric_limits<i32>::min();
+        bool needs_gravel = false;
+        bool needs_trees = false;
 
         // Precompute biome types and terrain heights
-        for (i32 x = 0; x < Chunk::CHUNK_SIZE; ++x) {
-            for (i32 z = 0; z < Chunk::CHUNK_SIZE; ++z) {
-                i32 world_x = chunk_pos.x * Chunk::CHUNK_SIZE + x;
-                i32 world_z = chunk_pos.z * Chunk::CHUNK_SIZE + z;
-                size_t index = x * Chunk::CHUNK_SIZE + z;
+        {
+            WorldGenStageScope stage(profile, WorldGenStage::HEIGHTS);
+            for (i32 x = 0; x < Chunk::CHUNK_SIZE; ++x) {
+                for (i32 z = 0; z < Chunk::CHUNK_SIZE; ++z) {
+                    size_t index = x * Chunk::CHUNK_SIZE + z;
+                    BiomeType biome = fields.biomes[(z + 1) * biome_grid_size + x + 1];
+
+                    biome_types[index] = biome;
+                    terrain_heights[index] = GetTerrainHeight(fields, x, z);
+                    min_terrain_height = std::min(min_terrain_height, terrain_heights[index]);
+                    max_terrain_height = std::max(max_terrain_height, terrain_heights[index]);
+                    max_surface_top = std::max(max_surface_top, GetSurfaceTop(terrain_heights[index], biome));
+                    needs_gravel |= biome == BiomeType::DESERT || biome == BiomeType::SAVANNA || biome == BiomeType::MESA;
+                    needs_trees |= chunk_pos.y == terrain_heights[index] / Chunk::CHUNK_SIZE;
+                }
+            }
+        }
 
-                biome_types[index] = GetBiomeType(world_x, world_z);
-                terrain_heights[index] = GetTerrainHeight(world_x, world_z, biome_types[index]);
+        // Nothing but air above the highest surface block of every column, and no tree starts there either
+        i32 chunk_min_y = world_origin.y;
+        i32 chunk_max_y = world_origin.y + Chunk::CHUNK_SIZE - 1;
+        if (chunk_min_y > max_surface_top) {
+            profile.chunk_class = ChunkGenClass::SKY;
+            return;
+        }
+
+        // Caves and gravel only ever replace ground, so a chunk entirely above the terrain skips them
+        bool has_ground = chunk_min_y <= max_terrain_height;
+
+        fields.has_caves = false;
+        if (has_ground) {
+            // Scaling the frequency by the spacing puts the lattice samples on the exact per-voxel ones
+            i32 spacing = m_cave_lattice_spacing.load();
+            i32 samples = GetLatticeSamplesPerAxis(Chunk::CHUNK_SIZE, spacing);
+            WorldGenStageScope stage(profile, WorldGenStage::CAVES, static_cast<u64>(samples) * samples * samples);
+
+            auto lattice_end = fields.cave_lattice.begin() + samples * samples * samples;
+            m_cave_fractal->GenUniformGrid3D(fields.cave_lattice.data(), world_origin.x / spacing, world_origin.y / spacing, world_origin.z / spacing,
+                samples, samples, samples, CAVE_SCALE * spacing, m_seed + 3);
+
+            // Interpolated values never exceed the lattice samples, so without a sample above the threshold there are no caves
+            fields.has_caves = *std::max_element(fields.cave_lattice.begin(), lattice_end) > CAVE_THRESHOLD;
+            if (fields.has_caves) {
+                UpsampleLattice3D(fields.cave_lattice.data(), Chunk::CHUNK_SIZE, spacing, fields.cave.data());
+            }
+        }
+        if (has_ground && needs_gravel) {
+            WorldGenStageScope stage(profile, WorldGenStage::GRAVEL, column_count);
+            m_biome_fractal->GenUniformGrid2D(fields.gravel.data(), world_origin.x, world_origin.z,
+                Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE, BIOME_SCALE, m_seed + 9);
+        }
+
+        // At least five blocks below every column's surface, above the bedrock and without caves the chunk is
+        // stone apart from gravel columns
+        if (chunk_max_y <= min_terrain_height - 5 && chunk_min_y > 0 && !fields.has_caves) {
+            profile.chunk_class = ChunkGenClass::SOLID;
+            {
+                WorldGenStageScope stage(profile, WorldGenStage::VOXEL_FILL);
+                FillUndergroundChunk(chunk, biome_types, fields);
             }
+            WorldGenStageScope stage(profile, WorldGenStage::FEATURES);
+            PlaceLavaPools(chunk);
+            PlaceOreVeins(chunk);
+            return;
         }
 
         // Generate voxels using precomputed data
+        {
+            WorldGenStageScope stage(profile, WorldGenStage::VOXEL_FILL);
+            for (i32 x = 0; x < Chunk::CHUNK_SIZE; ++x) {
+                for (i32 z = 0; z < Chunk::CHUNK_SIZE; ++z) {
+                    size_t index = x * Chunk::CHUNK_SIZE + z;
+                    size_t column = z * Chunk::CHUNK_SIZE + x;
+                    BiomeType biome = biome_types[index];
+                    i32 terrain_height = terrain_heights[index];
+
+                    // Everything above the column's surface top is air
+                    i32 column_end = std::min(Chunk::CHUNK_SIZE, GetSurfaceTop(terrain_height, biome) - world_origin.y + 1);
+                    for (i32 y = 0; y < column_end; ++y) {
+                        i32 world_y = world_origin.y + y;
+                        size_t voxel = (z * Chunk::CHUNK_SIZE + y) * Chunk::CHUNK_SIZE + x;
+                        VoxelType voxel_type = GetVoxelType(world_y, terrain_height, biome, fields, column, voxel);
+
+                        if (voxel_type != VoxelType::AIR) {
+                            glm::ivec3 local_pos(x, y, z);
+                            chunk.SetVoxel(local_pos, voxel_type);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Trees go in once the terrain of every column is there, the columns whose surface is in this chunk grow them
+        if (needs_trees) {
+            WorldGenStageScope stage(profile, WorldGenStage::TREES, column_count);
+            m_tree_fractal->GenUniformGrid2D(fields.tree.data(), world_origin.x, world_origin.z,
+                Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE, TREE_SCALE, m_seed + 5);
+
+            for (i32 x = 0; x < Chunk::CHUNK_SIZE; ++x) {
+                for (i32 z = 0; z < Chunk::CHUNK_SIZE; ++z) {
+                    size_t index = x * Chunk::CHUNK_SIZE + z;
+                    i32 terrain_height = terrain_heights[index];
+                    if (chunk_pos.y == terrain_height / Chunk::CHUNK_SIZE) {
+                        GenerateTrees(chunk, world_origin.x + x, world_origin.z + z, terrain_height, biome_types[index],
+                            fields.tree[z * Chunk::CHUNK_SIZE + x], structure_writes);
+                    }
+                }
+            }
+        }
+
+        if (has_ground) {
+            WorldGenStageScope stage(profile, WorldGenStage::FEATURES);
+            PlaceLavaPools(chunk);
+            PlaceOreVeins(chunk);
+        }
+    }
+
+    void Scene::FillUndergroundChunk(Chunk& chunk, const std::vector<BiomeType>& biome_types, const ChunkNoiseFields& fields) {
+        chunk.Fill(VoxelType::STONE);
+
+        // Same gravel rule as GetVoxelType, a gravel column reaches up to its biome elevation
+        i32 world_min_y = chunk.GetPosition().y * Chunk::CHUNK_SIZE;
         for (i32 x = 0; x < Chunk::CHUNK_SIZE; ++x) {
             for (i32 z = 0; z < Chunk::CHUNK_SIZE; ++z) {
-                i32 world_x = chunk_pos.x * Chunk::CHUNK_SIZE + x;
-                i32 world_z = chunk_pos.z * Chunk::CHUNK_SIZE + z;
-                size_t index = x * Chunk::CHUNK_SIZE + z;
-                BiomeType biome = biome_types[index];
-                i32 terrain_height = terrain_heights[index];
-
-                for (i32 y = 0; y < Chunk::CHUNK_SIZE; ++y) {
-                    i32 world_y = chunk_pos.y * Chunk::CHUNK_SIZE + y;
-                    VoxelType voxel_type = GetVoxelType(world_x, world_y, world_z, terrain_height, biome);
-
-                    if (voxel_type != VoxelType::AIR) {
-                        glm::ivec3 local_pos(x, y, z);
-                        chunk.SetVoxel(local_pos, voxel_type);
+                BiomeType biome = biome_types[x * Chunk::CHUNK_SIZE + z];
+                if (biome != BiomeType::DESERT && biome != BiomeType::SAVANNA && biome != BiomeType::MESA) {
+                    continue;
+                }
+
+                size_t column = z * Chunk::CHUNK_SIZE + x;
+                f32 gravel_noise = (fields.gravel[column] + 1.0f) / 2.0f;
+                if (gravel_noise <= 0.95f) {
+                    continue;
+                }
+
+                i32 column_end = std::min(Chunk::CHUNK_SIZE, GetBiomeElevation(fields.elevation[column], biome) - world_min_y + 1);
+                for (i32 y = 0; y < column_end; ++y) {
+                    chunk.SetVoxel(glm::ivec3(x, y, z), VoxelType::GRAVEL);
+                }
+            }
+        }
+    }
+
+    void Scene::PlaceLavaPools(Chunk& chunk) {
+        glm::ivec3 world_origin = chunk.GetPosition() * Chunk::CHUNK_SIZE;
+        if (world_origin.y >= LAVA_MAX_Y) {
+            return;
+        }
+
+        FeatureRandom random(chunk.GetPosition(), m_seed, 0);
+        if (random.NextFloat() >= LAVA_POOL_CHANCE) {
+            return;
+        }
+
+        // A flattened ellipsoid, cut off at LAVA_MAX_Y and kept clear of the bedrock layer
+        glm::ivec3 center(random.NextInt(Chunk::CHUNK_SIZE), random.NextInt(Chunk::CHUNK_SIZE), random.NextInt(Chunk::CHUNK_SIZE));
+        i32 radius = 2 + random.NextInt(LAVA_POOL_MAX_RADIUS - 1);
+        for (i32 dz = -radius; dz <= radius; ++dz) {
+            for (i32 dy = -radius / 2; dy <= radius / 2; ++dy) {
+                for (i32 dx = -radius; dx <= radius; ++dx) {
+                    if (dx * dx + 4 * dy * dy + dz * dz > radius * radius) {
+                        continue;
                     }
+                    glm::ivec3 local_pos = center + glm::ivec3(dx, dy, dz);
+                    i32 world_y = world_origin.y + local_pos.y;
+                    // Like ores, lava only replaces stone so pools never hang in cave air
+                    if (world_y <= 0 || world_y >= LAVA_MAX_Y || chunk.GetVoxel(local_pos) != VoxelType::STONE) {
+                        continue;
+                    }
+                    chunk.SetVoxel(local_pos, VoxelType::LAVA);
                 }
+            }
+        }
+    }
 
-                // Generate trees if necessary
-                if (chunk_pos.y == terrain_height / Chunk::CHUNK_SIZE) {
-                    GenerateTrees(chunk, world_x, world_z, terrain_height % Chunk::CHUNK_SIZE, biome);
+    void Scene::PlaceOreVeins(Chunk& chunk) {
+        glm::ivec3 world_origin = chunk.GetPosition() * Chunk::CHUNK_SIZE;
+        if (world_origin.y + Chunk::CHUNK_SIZE <= ORE_MIN_Y || world_origin.y >= ORE_MAX_Y) {
+            return;
+        }
+
+        for (u32 vein_type = 0; vein_type < std::size(ORE_VEINS); ++vein_type) {
+            const OreVein& vein = ORE_VEINS[vein_type];
+            FeatureRandom random(chunk.GetPosition(), m_seed, vein_type + 1);
+
+            for (i32 i = 0; i < vein.veins_per_chunk; ++i) {
+                glm::ivec3 pos(random.NextInt(Chunk::CHUNK_SIZE), random.NextInt(Chunk::CHUNK_SIZE), random.NextInt(Chunk::CHUNK_SIZE));
+
+                // Grow the vein by walking one step along a random axis at a time, ores only replace stone
+                for (i32 step = 0; step < vein.vein_size; ++step) {
+                    i32 world_y = world_origin.y + pos.y;
+                    if (world_y > ORE_MIN_Y && world_y < vein.max_y && chunk.GetVoxel(pos) == VoxelType::STONE) {
+                        chunk.SetVoxel(pos, vein.ore);
+                    }
+
+                    u32 direction = random.Next();
+                    pos[direction % 3] += (direction & 4) ? 1 : -1;
+                    pos = glm::clamp(pos, glm::ivec3(0), glm::ivec3(Chunk::CHUNK_SIZE - 1));
                 }
             }
         }
     }
 
+    void Scene::RecordColumnHeights(const glm::ivec3& chunk_pos, const std::vector<i32>& terrain_heights) {
+        // Every chunk in a column generates the same heights, the first one to load keeps them
+        auto [column_it, inserted] = m_column_heights.try_emplace(glm::ivec2(chunk_pos.x, chunk_pos.z));
+        if (!inserted) {
+            return;
+        }
+
+        ChunkColumnHeights& column = column_it->second;
+        column.min_height = std::numeric_limits<i32>::max();
+        column.max_height = std::numeric_limits<i32>::min();
+        for (size_t i = 0; i < terrain_heights.size(); ++i) {
+            column.heights[i] = static_cast<i16>(terrain_heights[i]);
+            column.min_height = std::min(column.min_height, terrain_heights[i]);
+            column.max_height = std::max(column.max_height, terrain_heights[i]);
+        }
+    }
+
     void Scene::SetSkyColor(const glm::vec4& sky_color) {
         m_sky_color = sky_color;
     }
 
+    void Scene::SetSeed(u32 seed) {
+        m_seed = seed;
+    }
+
+    u32 Scene::GetSeed() const {
+        return m_seed;
+    }
+
     glm::vec4 Scene::GetSkyColor() const {
         return m_sky_color;
     }
@@ -608,7 +1146,7 @@ namespace MC {
     }
 
     void Scene::InsertVoxel(VoxelType voxel_type, const glm::ivec3& world_pos) {
-        std::lock_guard<std::mutex> lock(m_chunk_mutex);
+        std::lock_guard<std::shared_mutex> lock(m_chunk_mutex);
 
         glm::ivec3 chunk_pos, local_pos;
         WorldToChunkLocal(world_pos, chunk_pos, local_pos);
@@ -616,11 +1154,12 @@ namespace MC {
         // Get or create the chunk
         auto chunk_it = m_chunks.find(chunk_pos);
         if (chunk_it == m_chunks.end()) {
-            m_chunks.emplace(
+            chunk_it = m_chunks.emplace(
                 chunk_pos,
                 std::make_shared<Chunk>(chunk_pos)
-            );
-            chunk_it = m_chunks.find(chunk_pos);
+            ).first;
+            u32 region = m_region_grid.Add(chunk_pos);
+            m_render_table.Add(chunk_pos, chunk_it->second.get(), region);
         }
 
         Chunk& chunk = *chunk_it->second;
@@ -630,7 +1169,7 @@ namespace MC {
     }
 
     void Scene::RemoveVoxel(u32 voxel_id) {
-        std::lock_guard<std::mutex> lock(m_chunk_mutex);
+        std::lock_guard<std::shared_mutex> lock(m_chunk_mutex);
         auto voxelLocIt = m_voxelLocations.find(voxel_id);
         if (voxelLocIt == m_voxelLocations.end()) {
             LOG_ERROR("Attempted to remove non-existent voxel with ID: " << voxel_id);
@@ -649,7 +1188,7 @@ namespace MC {
     }
 
     std::optional<Voxel> Scene::GetVoxel(u32 id) const {
-        std::lock_guard<std::mutex> lock(m_chunk_mutex);
+        std::shared_lock<std::shared_mutex> lock(m_chunk_mutex);
         auto voxel_loc_it = m_voxelLocations.find(id);
         if (voxel_loc_it == m_voxelLocations.end()) {
             return std::nullopt;
@@ -670,6 +1209,8 @@ namespace MC {
         glm::ivec3 chunk_pos, local_pos;
         WorldToChunkLocal(world_pos, chunk_pos, local_pos);
 
+        // Called from mesh jobs while the main thread publishes and unloads chunks
+        std::shared_lock<std::shared_mutex> lock(m_chunk_mutex);
         auto chunk_it = m_chunks.find(chunk_pos);
         if (chunk_it != m_chunks.end()) {
             const Chunk& chunk = *chunk_it->second;
@@ -683,16 +1224,116 @@ namespace MC {
         return m_chunks;
     }
 
+    ChunkRegionGrid& Scene::GetRegionGrid() {
+        return m_region_grid;
+    }
+
+    const ChunkRenderTable& Scene::GetRenderTable() const {
+        return m_render_table;
+    }
+
+    const std::unordered_map<glm::ivec2, ChunkColumnHeights>& Scene::GetColumnHeights() const {
+        return m_column_heights;
+    }
+
+    ChunkMeshArena& Scene::GetMeshArena() const {
+        return *m_mesh_arena;
+    }
+
+    GLResourceManager& Scene::GetGLResources() const {
+        return *m_gl_resources;
+    }
+
+    IChunkMeshSink& Scene::GetMeshSink() const {
+        return *m_mesh_sink;
+    }
+
     Camera& Scene::GetCamera() const {
         return *m_camera;
     }
 
+    void Scene::ReleaseRetiredChunks() {
+        auto first_pending = std::partition(m_retired_chunks.begin(), m_retired_chunks.end(), [](const std::shared_ptr<Chunk>& chunk) {
+            return !chunk->IsMeshGenerationPending();
+            });
+
+        for (auto it = m_retired_chunks.begin(); it != first_pending; ++it) {
+            (*it)->ReleaseMeshData(*m_mesh_sink);
+        }
+
+        m_retired_chunks.erase(m_retired_chunks.begin(), first_pending);
+    }
+
     void Scene::UpdateChunks() {
-        for (auto& [chunk_pos, chunk] : m_chunks) {
-            if (chunk->NeedsMeshUpdate() || !chunk->IsMeshDataUploaded()) {
+        ReleaseRetiredChunks();
+        if (m_gl_resources) {
+            m_gl_resources->CollectGarbage();
+        }
+
+        glm::vec3 camera_pos = m_camera->GetPosition();
+        const Frustum& frustum = m_camera->GetFrustum();
+
+        // Walk the dense table rather than the chunk map, the bounds are already laid out per row
+        const ChunkRenderRows& rows = m_render_table.GetRows();
+        for (size_t row = 0; row < m_render_table.GetSize(); ++row) {
+            Chunk* chunk = rows.chunk[row];
+            if (chunk->NeedsMeshUpdate()) {
                 chunk->Update(*this, m_thread_pool);
             }
+
+            if (chunk->HasMeshDataGenerated() && !chunk->IsMeshDataUploaded() && !chunk->IsMeshGenerationPending()) {
+                glm::vec3 chunk_min(rows.min_x[row], rows.min_y[row], rows.min_z[row]);
+                glm::vec3 chunk_max(rows.max_x[row], rows.max_y[row], rows.max_z[row]);
+                glm::vec3 to_chunk = (chunk_min + chunk_max) * 0.5f - camera_pos;
+
+                // Nearest first, anything outside last frame's frustum goes behind every visible chunk
+                f32 priority = glm::dot(to_chunk, to_chunk);
+                if (!frustum.IsBoxVisible(chunk_min, chunk_max)) {
+                    priority += UPLOAD_OFFSCREEN_PRIORITY_PENALTY;
+                }
+
+                m_upload_queue.Push(m_chunks.at(rows.position[row]), priority);
+            }
+        }
+
+        m_upload_queue.Process(*m_mesh_sink);
+
+        // The previous mesh range stays drawable until the rebuilt one replaces it here
+        for (Chunk* chunk : m_upload_queue.GetUploadedChunks()) {
+            m_render_table.SetMesh(chunk->GetPosition(), chunk->GetMeshAllocation());
+        }
+    }
+
+    void Scene::SetMeshUploadBudget(const MeshUploadBudget& budget) {
+        m_upload_queue.SetBudget(budget);
+    }
+
+    const MeshUploadStats& Scene::GetMeshUploadStats() const {
+        return m_upload_queue.GetStats();
+    }
+
+    const ChunkStreamingStats& Scene::GetStreamingStats() const {
+        return m_streaming_stats;
+    }
+
+    void Scene::SetChunkGenerationBudget(const ChunkGenerationBudget& budget) {
+        m_generation_budget = budget;
+    }
+
+    const ChunkGenerationBudget& Scene::GetChunkGenerationBudget() const {
+        return m_generation_budget;
+    }
+
+    void Scene::SetCaveLatticeSpacing(i32 spacing) {
+        if (spacing < 1 || spacing > Chunk::CHUNK_SIZE || (spacing & (spacing - 1)) != 0) {
+            LOG_WARN("Ignoring cave lattice spacing " << spacing << ", it must be a power of two up to " << Chunk::CHUNK_SIZE);
+            return;
         }
+        m_cave_lattice_spacing = spacing;
+    }
+
+    i32 Scene::GetCaveLatticeSpacing() const {
+        return m_cave_lattice_spacing.load();
     }
 
     std::optional<VoxelHitInfo> Scene::GetVoxelLookedAt(f32 max_distance) const {
@@ -14,7 +14,16 @@
 #include "voxel_hit_info.hpp"
 #include "thread_pool.hpp"
 #include "sun.hpp"
+#include "chunk_region_grid.hpp"
+#include "chunk_render_table.hpp"
+#include "gl_resource_manager.hpp"
+#include "mesh_arena.hpp"
+#include "mesh_upload_queue.hpp"
+#include "noise_lattice.hpp"
+#include <atomic>
+#include <future>
 #include <mutex>
+#include <shared_mutex>
 
 namespace MC {
     enum class BiomeType {
@@ -34,15 +43,49 @@ namespace MC {
         MESA
     };
 
+    // Terrain surface heights of one column of chunks, kept while the column is in load range
+    struct ChunkColumnHeights {
+        std::array<i16, Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE> heights; // Indexed x * CHUNK_SIZE + z
+        i32 min_height = 0;
+        i32 max_height = 0;
+    };
+
+    // Totals since the scene was initialized
+    struct ChunkStreamingStats {
+        u64 chunks_loaded = 0;
+        u64 chunks_unloaded = 0;
+        u64 chunks_discarded = 0;       // Generated but out of range, outside its column's terrain or already present once finished
+        size_t generation_jobs = 0;     // In flight at the end of the last update
+    };
+
+    // Limits how many chunks are generated on the thread pool at once
+    struct ChunkGenerationBudget {
+        size_t max_jobs_in_flight = 16;
+        f32 behind_camera_weight = 1.0f; // Chunks straight behind the camera count as this much further away
+    };
+
     class Scene {
     public:
         Scene(EventHandler& event_handler, ThreadPool& tp);
         ~Scene();
 
+        // Needs a current GL context, meshes go up to the GPU arena
         void InitializeScene();
 
+        // Touches no GL at all, meshes are still built but only recorded
+        void InitializeHeadlessScene();
+        bool IsHeadless() const;
+
         void SetSkyColor(const glm::vec4& sky_color);
 
+        // Chunk contents follow from the seed alone, set it before the scene is initialized
+        void SetSeed(u32 seed);
+        u32 GetSeed() const;
+
+        // Generates and publishes every chunk in the inclusive box of chunk positions and returns once all are in,
+        // ignoring the load range and the generation budget. For tools that need a fixed region
+        void GenerateRegion(const glm::ivec3& min_chunk_pos, const glm::ivec3& max_chunk_pos);
+
         // Accessors
         Camera& GetCamera() const;
         glm::vec4 GetSkyColor() const;
@@ -51,6 +94,22 @@ namespace MC {
         // Get all chunks
         std::unordered_map<glm::ivec3, std::shared_ptr<Chunk>>& GetChunks();
 
+        // Loaded chunks grouped into regions for coarse culling
+        ChunkRegionGrid& GetRegionGrid();
+
+        // Bounds and mesh ranges of the loaded chunks in one dense table
+        const ChunkRenderTable& GetRenderTable() const;
+
+        // Surface heights of the loaded chunk columns, keyed by chunk x and z
+        const std::unordered_map<glm::ivec2, ChunkColumnHeights>& GetColumnHeights() const;
+
+        // Shared GPU storage for every chunk mesh, only there when not headless
+        ChunkMeshArena& GetMeshArena() const;
+        GLResourceManager& GetGLResources() const;
+
+        // Where uploaded meshes go, the arena or the headless recording sink
+        IChunkMeshSink& GetMeshSink() const;
+
         // Voxel retrieval
         std::optional<Voxel> GetVoxel(u32 id) const;
         VoxelType GetVoxelAtPosition(const glm::ivec3& world_pos) const;
@@ -67,21 +126,96 @@ namespace MC {
 
         void UpdateChunks();
 
+        // Limits how much finished mesh data is pushed to the GPU each frame
+        void SetMeshUploadBudget(const MeshUploadBudget& budget);
+        const MeshUploadStats& GetMeshUploadStats() const;
+
+        const ChunkStreamingStats& GetStreamingStats() const;
+
+        void SetChunkGenerationBudget(const ChunkGenerationBudget& budget);
+        const ChunkGenerationBudget& GetChunkGenerationBudget() const;
+
+        // Cave density is sampled every spacing voxels and interpolated in between, 1 samples every voxel.
+        // Must be a power of two up to the chunk size, applies to chunks generated afterwards
+        void SetCaveLatticeSpacing(i32 spacing);
+        i32 GetCaveLatticeSpacing() const;
+
     private:
+        // Noise of one chunk, every field is evaluated for the whole chunk with one batched FastNoise
+        // grid call. 2D fields are indexed z * CHUNK_SIZE + x and 3D fields (z * CHUNK_SIZE + y) * CHUNK_SIZE + x,
+        // the order FastNoise fills its grids in
+        struct ChunkNoiseFields {
+            // Biome noise is only sampled every BIOME_CELL_SIZE blocks, from one cell before the chunk to one past it
+            static constexpr i32 BIOME_CELL_SIZE = 4;
+            static constexpr i32 BIOME_COARSE_SIZE = Chunk::CHUNK_SIZE / BIOME_CELL_SIZE + 3;
+            // Upsampled biomes reach one column past each side for the height blending
+            static constexpr i32 BIOME_GRID_SIZE = Chunk::CHUNK_SIZE + 2;
+            static constexpr size_t COLUMN_COUNT = Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE;
+            static constexpr size_t VOXEL_COUNT = COLUMN_COUNT * Chunk::CHUNK_SIZE;
+
+            std::array<f32, BIOME_COARSE_SIZE * BIOME_COARSE_SIZE> temperature;
+            std::array<f32, BIOME_COARSE_SIZE * BIOME_COARSE_SIZE> humidity;
+            std::array<BiomeType, BIOME_GRID_SIZE * BIOME_GRID_SIZE> biomes;
+            // Biome elevation curves box filtered over 3x3 columns, first along x into the rows then along z
+            std::array<f32, BIOME_GRID_SIZE * Chunk::CHUNK_SIZE> row_height_scale;
+            std::array<f32, BIOME_GRID_SIZE * Chunk::CHUNK_SIZE> row_height_offset;
+            std::array<f32, COLUMN_COUNT> height_scale;
+            std::array<f32, COLUMN_COUNT> height_offset;
+            bool has_caves = false; // Any cave density above the threshold in the chunk
+            std::array<f32, COLUMN_COUNT> elevation;      // Octaves combined, in [0, 1]
+            std::array<f32, COLUMN_COUNT> elevation_octave;
+            std::array<f32, COLUMN_COUNT> gravel;
+            std::array<f32, COLUMN_COUNT> tree;
+            std::array<f32, VOXEL_COUNT> cave;            // Interpolated from the lattice, only when has_caves
+            std::array<f32, (Chunk::CHUNK_SIZE + 1) * (Chunk::CHUNK_SIZE + 1) * (Chunk::CHUNK_SIZE + 1)> cave_lattice;
+        };
+
+        // A voxel a structure places in another chunk than the one generating it
+        struct StructureWrite {
+            glm::ivec3 world_pos;
+            VoxelType voxel_type;
+        };
+
+        // A chunk generated on the thread pool, detached from the scene until the job is done
+        struct ChunkGenerationJob {
+            std::shared_ptr<Chunk> chunk;
+            std::vector<i32> terrain_heights;
+            std::vector<StructureWrite> structure_writes;
+            std::future<void> done;
+        };
+
         // Helper functions
-        void GenerateChunk(const glm::ivec3& chunk_pos);
-        void GenerateVoxelDataForChunk(Chunk& chunk);
-        void GenerateTrees(Chunk& chunk, i32 world_x, i32 world_z, i32 terrain_height, BiomeType biome);
-        BiomeType GetBiomeType(i32 world_x, i32 world_z);
-        f32 ComputeElevationNoise(f32 x, f32 z);
+        void StartChunkGeneration(const glm::ivec3& chunk_pos);
+        void PublishGeneratedChunks(const glm::ivec3& player_chunk_pos);
+        void PublishChunk(const glm::ivec3& chunk_pos, ChunkGenerationJob& job);
+        void ReleaseRetiredChunks();
+        void RecordColumnHeights(const glm::ivec3& chunk_pos, const std::vector<i32>& terrain_heights);
+        void GenerateVoxelDataForChunk(Chunk& chunk, std::vector<i32>& terrain_heights, std::vector<StructureWrite>& structure_writes);
+        void FillUndergroundChunk(Chunk& chunk, const std::vector<BiomeType>& biome_types, const ChunkNoiseFields& fields);
+
+        // Features placed from a hash of the chunk position, their cost grows with the feature count only
+        void PlaceLavaPools(Chunk& chunk);
+        void PlaceOreVeins(Chunk& chunk);
+        void GenerateTrees(Chunk& chunk, i32 world_x, i32 world_z, i32 terrain_height, BiomeType biome, f32 tree_noise,
+            std::vector<StructureWrite>& structure_writes);
+
+        // Structures write in world coordinates, what lands outside the generating chunk is handed to the main thread
+        void PlaceStructureVoxel(Chunk& chunk, const glm::ivec3& world_pos, VoxelType voxel_type, std::vector<StructureWrite>& structure_writes);
+        void ApplyStructureWrites(const std::vector<StructureWrite>& structure_writes);
+        BiomeType GetBiomeType(f32 temperature, f32 humidity) const;
+        void ComputeBiomes(const glm::ivec3& chunk_pos, ChunkNoiseFields& fields);
+        void ComputeElevationNoise(const glm::ivec3& chunk_pos, ChunkNoiseFields& fields);
         i32 GetBiomeElevation(f32 elevation, BiomeType biome);
-        i32 GetTerrainHeight(i32 world_x, i32 world_z, BiomeType biome);
-        VoxelType GetVoxelType(i32 world_x, i32 world_y, i32 world_z, i32 terrain_height, BiomeType biome);
-        bool IsCave(i32 world_x, i32 world_y, i32 world_z);
+        i32 GetTerrainHeight(const ChunkNoiseFields& fields, i32 x, i32 z);
+        VoxelType GetVoxelType(i32 world_y, i32 terrain_height, BiomeType biome,
+            const ChunkNoiseFields& fields, size_t column, size_t voxel);
 
     private:
         // Chunks stored by their positions in chunk coordinates
         std::unordered_map<glm::ivec3, std::shared_ptr<Chunk>> m_chunks;
+        ChunkRegionGrid m_region_grid;
+        ChunkRenderTable m_render_table;
+        std::unordered_map<glm::ivec2, ChunkColumnHeights> m_column_heights;
 
         // Map of voxel IDs to their chunk positions and local positions
         std::unordered_map<u32, std::pair<glm::ivec3, glm::ivec3>> m_voxelLocations;
@@ -90,11 +224,30 @@ namespace MC {
         glm::vec4 m_sky_color;
         glm::ivec3 m_last_player_chunk_pos;
         EventHandler& m_event_handler;
-        mutable std::mutex m_chunk_mutex; // Mutex for thread safety
+        // Mesh jobs read neighbouring chunks shared, the main thread adds and removes chunks exclusively
+        mutable std::shared_mutex m_chunk_mutex;
         // Thread pool for chunk generation
         ThreadPool& m_thread_pool;
         u32 m_seed;
         Sun m_sun;
+        std::unique_ptr<GLResourceManager> m_gl_resources;
+        std::unique_ptr<ChunkMeshArena> m_mesh_arena;
+        std::unique_ptr<RecordingMeshSink> m_recording_sink;
+        IChunkMeshSink* m_mesh_sink = nullptr;
+        MeshUploadQueue m_upload_queue;
+        ChunkStreamingStats m_streaming_stats;
+
+        // Only touched by the main thread, each job writes to its own entry until its future is ready
+        std::unordered_map<glm::ivec3, ChunkGenerationJob> m_generation_jobs;
+        ChunkGenerationBudget m_generation_budget;
+
+        // Structure voxels each loaded chunk wrote into its neighbours, kept until it unloads so a neighbour
+        // published again gets them again, main thread only
+        std::unordered_map<glm::ivec3, std::vector<StructureWrite>> m_structure_writes;
+        std::atomic<i32> m_cave_lattice_spacing = 4;
+
+        // Unloaded chunks kept alive until their mesh job has finished
+        std::vector<std::shared_ptr<Chunk>> m_retired_chunks;
 
         FastNoise::SmartNode<FastNoise::Perlin> m_elevation_generator;
         FastNoise::SmartNode<FastNoise::FractalFBm> m_elevation_fractal;
@@ -108,9 +261,6 @@ namespace MC {
         FastNoise::SmartNode<FastNoise::Perlin> m_tree_generator;
         FastNoise::SmartNode<FastNoise::FractalFBm> m_tree_fractal;
 
-        FastNoise::SmartNode<FastNoise::Perlin> m_ore_generator;
-        FastNoise::SmartNode<FastNoise::FractalFBm> m_ore_fractal;
-
         FastNoise::SmartNode<FastNoise::Perlin> m_temperature_generator;
         FastNoise::SmartNode<FastNoise::FractalFBm> m_temperature_fractal;
 
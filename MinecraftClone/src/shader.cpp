@@ -1,5 +1,6 @@
 #include "shader.hpp"
 #include "log.hpp"
+#include "gl_trace.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -25,38 +26,73 @@ namespace MC {
 		// Delete shaders after linking
 		glDeleteShader(vertex_shader);
 		glDeleteShader(fragment_shader);
+
+		CacheUniformLocations();
 	}
 
 	Shader::~Shader() {
-		glDeleteProgram(m_program_id);
+		GL::DeleteProgram(m_program_id);
 	}
 
 	void Shader::Use() const {
-		glUseProgram(m_program_id);
+		GL::UseProgram(m_program_id);
 	}
 
 	void Shader::SetBool(const std::string& name, bool value) const {
-		glUniform1i(glGetUniformLocation(m_program_id, name.c_str()), static_cast<i32>(value));
+		GL::Uniform1i(GetUniformLocation(name), static_cast<i32>(value));
 	}
 
 	void Shader::SetInt(const std::string& name, i32 value) const {
-		glUniform1i(glGetUniformLocation(m_program_id, name.c_str()), value);
+		GL::Uniform1i(GetUniformLocation(name), value);
 	}
 
 	void Shader::SetFloat(const std::string& name, f32 value) const {
-		glUniform1f(glGetUniformLocation(m_program_id, name.c_str()), value);
+		GL::Uniform1f(GetUniformLocation(name), value);
 	}
 
 	void Shader::SetVec3(const std::string& name, const glm::vec3& value) const {
-		glUniform3fv(glGetUniformLocation(m_program_id, name.c_str()), 1, glm::value_ptr(value));
+		GL::Uniform3fv(GetUniformLocation(name), glm::value_ptr(value));
 	}
 
 	void Shader::SetVec4(const std::string& name, const glm::vec4& value) const {
-		glUniform4fv(glGetUniformLocation(m_program_id, name.c_str()), 1, glm::value_ptr(value));
+		GL::Uniform4fv(GetUniformLocation(name), glm::value_ptr(value));
 	}
 
 	void Shader::SetMat4(const std::string& name, const glm::mat4& value) const {
-		glUniformMatrix4fv(glGetUniformLocation(m_program_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+		GL::UniformMatrix4fv(GetUniformLocation(name), glm::value_ptr(value));
+	}
+
+	i32 Shader::GetUniformLocation(const std::string& name) const {
+		auto it = m_uniform_locations.find(name);
+		return it != m_uniform_locations.end() ? it->second : -1;
+	}
+
+	void Shader::BindUniformBlock(const std::string& name, u32 binding) const {
+		GLuint block_index = glGetUniformBlockIndex(m_program_id, name.c_str());
+		if (block_index == GL_INVALID_INDEX) {
+			LOG_WARN("Uniform block " << name << " is not used by the shader");
+			return;
+		}
+		glUniformBlockBinding(m_program_id, block_index, binding);
+	}
+
+	void Shader::CacheUniformLocations() {
+		GLint uniform_count = 0;
+		glGetProgramiv(m_program_id, GL_ACTIVE_UNIFORMS, &uniform_count);
+
+		GLchar name[256];
+		for (GLint i = 0; i < uniform_count; ++i) {
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(m_program_id, i, sizeof(name), &length, &size, &type, name);
+
+			// Members of uniform blocks have no location
+			GLint location = glGetUniformLocation(m_program_id, name);
+			if (location != -1) {
+				m_uniform_locations.emplace(std::string(name, length), location);
+			}
+		}
 	}
 
 	std::string Shader::ReadShaderFile(const std::string& file_path) const {
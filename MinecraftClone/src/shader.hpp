@@ -2,6 +2,7 @@
 #define SHADER_HPP
 
 #include <string>
+#include <unordered_map>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -23,14 +24,22 @@ namespace MC {
         void SetVec3(const std::string& name, const glm::vec3& value) const;
         void SetVec4(const std::string& name, const glm::vec4& value) const;
         void SetMat4(const std::string& name, const glm::mat4& value) const;
+
+        // Location resolved at link time, -1 if the program has no such uniform
+        i32 GetUniformLocation(const std::string& name) const;
+
+        // Attaches a uniform block to a buffer binding point
+        void BindUniformBlock(const std::string& name, u32 binding) const;
     private:
         // Private utility functions
         std::string ReadShaderFile(const std::string& file_path) const;
         GLuint CompileShader(const std::string& code, GLenum type) const;
         void CheckCompileErrors(GLuint shader, GLenum type) const;
+        void CacheUniformLocations();
 
     private:
         u32 m_program_id;
+        std::unordered_map<std::string, i32> m_uniform_locations;
     };
 }
 
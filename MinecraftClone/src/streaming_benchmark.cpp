@@ -0,0 +1,66 @@
+#include "streaming_benchmark.hpp"
+#include "application.hpp"
+#include "log.hpp"
+#include "world_gen_profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace MC {
+    namespace {
+        const glm::vec3 STREAMING_START = glm::vec3(10.0f, 100.0f, 10.0f);
+        const glm::vec3 STREAMING_DIRECTION = glm::vec3(1.0f, 0.0f, 0.0f);
+    }
+
+    void RunStreamingBenchmark(const StreamingBenchmarkSettings& settings) {
+        LOG_INFO("Streaming benchmark: headless, " << settings.frames << " frames at " << settings.speed << " blocks per frame");
+
+        FrameTimings total_timings;
+        u32 frame = 0;
+        WorldGenProfiler::Reset();
+        auto start = std::chrono::steady_clock::now();
+
+        Application app;
+        app.CreateHeadless()
+            .AddUpdateFunction([&](Application& app) {
+                    // Update functions run first in the frame, so the timings are those of the frame before
+                    if (frame > 0) {
+                        const FrameTimings& timings = app.GetFrameTimings();
+                        total_timings.chunk_streaming += timings.chunk_streaming;
+                        total_timings.chunk_updates += timings.chunk_updates;
+                        total_timings.frame += timings.frame;
+                    }
+
+                    if (frame > 0 && frame % settings.report_interval == 0) {
+                        const Scene& scene = app.GetScene();
+                        LOG_INFO("Frame " << frame << ": " << scene.GetStreamingStats().chunks_loaded << " chunks loaded, "
+                            << scene.GetStreamingStats().generation_jobs << " generating, "
+                            << scene.GetMeshSink().GetStats().live_meshes << " meshes live, "
+                            << scene.GetMeshUploadStats().queue_depth << " waiting for upload");
+                    }
+
+                    if (frame == settings.frames) {
+                        app.Shutdown();
+                        return;
+                    }
+
+                    app.GetScene().GetCamera().SetPosition(STREAMING_START + STREAMING_DIRECTION * (settings.speed * frame));
+                    ++frame;
+                })
+            .Start();
+
+        std::chrono::duration<f64> elapsed = std::chrono::steady_clock::now() - start;
+        const Scene& scene = app.GetScene();
+        const ChunkStreamingStats& streaming = scene.GetStreamingStats();
+        const MeshSinkStats& meshes = scene.GetMeshSink().GetStats();
+        f64 measured_frames = std::max<f64>(frame - 1, 1.0);
+
+        LOG_INFO("Loaded " << streaming.chunks_loaded << " and unloaded " << streaming.chunks_unloaded << " chunks in " << elapsed.count() << " s, "
+            << streaming.chunks_loaded / elapsed.count() << " chunks/s, " << streaming.chunks_discarded << " generated chunks discarded");
+        LOG_INFO("Uploaded " << meshes.uploads << " meshes, " << meshes.uploaded_bytes / (1024.0 * 1024.0) << " MiB, "
+            << meshes.uploads / elapsed.count() << " meshes/s");
+        LOG_INFO("Average frame (us): " << total_timings.frame / measured_frames << ", chunk streaming " << total_timings.chunk_streaming / measured_frames
+            << ", chunk updates " << total_timings.chunk_updates / measured_frames);
+        WorldGenProfiler::LogReport(WorldGenProfiler::GetTotals());
+    }
+}
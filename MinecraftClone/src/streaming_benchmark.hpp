@@ -0,0 +1,18 @@
+#ifndef STREAMING_BENCHMARK_HPP
+#define STREAMING_BENCHMARK_HPP
+
+#include "types.hpp"
+
+namespace MC {
+    struct StreamingBenchmarkSettings {
+        u32 frames = 3000;
+        f32 speed = 1.0f;        // Blocks the camera moves per frame
+        u32 report_interval = 500; // Frames between progress lines
+    };
+
+    // Flies the camera through a headless application, which streams, generates and meshes chunks
+    // without any GL, and reports how fast chunks get loaded. Needs no display or GPU
+    void RunStreamingBenchmark(const StreamingBenchmarkSettings& settings = {});
+}
+
+#endif // STREAMING_BENCHMARK_HPP
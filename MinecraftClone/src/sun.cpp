@@ -1,4 +1,5 @@
 #include "sun.hpp"
+#include "gl_trace.hpp"
 
 #include <GL/glew.h>
 
@@ -11,13 +12,13 @@ namespace MC
 		glGenBuffers(1, &m_sun_vbo);
 		glGenBuffers(1, &m_sun_ebo);
 
-		glBindVertexArray(m_sun_vao);
+		GL::BindVertexArray(m_sun_vao);
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_sun_vbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(SUN_VERTICES), SUN_VERTICES, GL_STATIC_DRAW);
+		GL::BindBuffer(GL_ARRAY_BUFFER, m_sun_vbo);
+		GL::BufferData(GL_ARRAY_BUFFER, sizeof(SUN_VERTICES), SUN_VERTICES, GL_STATIC_DRAW);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_sun_ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(SUN_INDICES), SUN_INDICES, GL_STATIC_DRAW);
+		GL::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_sun_ebo);
+		GL::BufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(SUN_INDICES), SUN_INDICES, GL_STATIC_DRAW);
 
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
@@ -32,14 +33,19 @@ namespace MC
 			(void*)offsetof(Vertex, color)
 		);
 
-		glBindVertexArray(0);
+		GL::BindVertexArray(0);
 	}
 
 	Sun::~Sun()
 	{
-		glDeleteBuffers(1, &m_sun_vbo);
-		glDeleteBuffers(1, &m_sun_ebo);
-		glDeleteVertexArrays(1, &m_sun_vao);
+		// Never initialized in a headless scene, there may not even be a GL context
+		if (m_sun_vao == 0) {
+			return;
+		}
+
+		GL::DeleteBuffer(m_sun_vbo);
+		GL::DeleteBuffer(m_sun_ebo);
+		GL::DeleteVertexArray(m_sun_vao);
 	}
 
 }
@@ -1,4 +1,5 @@
 #include "thread_pool.hpp"
+#include <algorithm>
 #include <random>
 
 namespace MC {
@@ -68,6 +69,47 @@ namespace MC {
 		}
 	}
 
+	size_t ThreadPool::GetBatchCount(size_t count, size_t batch_size) {
+		return (count + batch_size - 1) / batch_size;
+	}
+
+	void ThreadPool::ParallelFor(size_t count, size_t batch_size, const std::function<void(size_t, size_t, size_t)>& fn) {
+		size_t batch_count = GetBatchCount(count, batch_size);
+		if (batch_count == 0) {
+			return;
+		}
+		if (batch_count == 1) {
+			fn(0, 0, count);
+			return;
+		}
+
+		struct SharedState {
+			std::atomic<size_t> next_batch{ 0 };
+			std::atomic<size_t> completed_batches{ 0 };
+		};
+
+		// Helpers that only start after everything is done find no batch left and never touch fn
+		auto state = std::make_shared<SharedState>();
+		auto run_batches = [state, &fn, count, batch_size, batch_count]() {
+			for (size_t batch = state->next_batch.fetch_add(1, std::memory_order_relaxed); batch < batch_count; batch = state->next_batch.fetch_add(1, std::memory_order_relaxed)) {
+				size_t begin = batch * batch_size;
+				fn(batch, begin, std::min(begin + batch_size, count));
+				state->completed_batches.fetch_add(1, std::memory_order_release);
+			}
+		};
+
+		size_t helper_count = std::min(batch_count - 1, m_workers.size());
+		for (size_t i = 0; i < helper_count; ++i) {
+			Enqueue(TaskPriority::CRITICAL, false, run_batches);
+		}
+
+		run_batches();
+
+		while (state->completed_batches.load(std::memory_order_acquire) < batch_count) {
+			std::this_thread::yield();
+		}
+	}
+
 	void ThreadPool::WaitForAllTasks() {
 		std::unique_lock<std::mutex> lock(m_queue_mutex);
 		m_sync_condition.wait(lock, [this] { return m_active_tasks.load(std::memory_order_acquire) == 0 && AllQueuesEmpty(); });
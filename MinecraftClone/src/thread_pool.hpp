@@ -37,6 +37,12 @@ namespace MC {
 		void                                                                                        ExecuteAndWait(const std::vector<std::function<void()>>& tasks);
 		void                                                                                        WaitForAllTasks();
 
+		// Splits [0, count) into batches of batch_size and runs fn(batch, begin, end) for each of them on the
+		// workers and the calling thread, returning once every batch is done. Whoever is free claims the next
+		// batch, so the caller never waits on a worker that is still busy with an unrelated task
+		void                                                                                        ParallelFor(size_t count, size_t batch_size, const std::function<void(size_t, size_t, size_t)>& fn);
+		static size_t                                                                               GetBatchCount(size_t count, size_t batch_size);
+
 	private:
 		void                  Initialize(u32 num_threads);
 		void                  Shutdown();
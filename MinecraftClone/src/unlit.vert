@@ -2,10 +2,18 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec4 aColor; // Color attribute
+layout(location = 3) in vec3 aChunkOffset; // Per-draw chunk position, zero for the sun
+
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightDirection;
+    vec4 lightColor;
+    vec4 ambientLightColor;
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -13,8 +21,10 @@ out vec4 VertexColor; // Pass to fragment shader
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    // model is identity for chunks and a uniform scale plus translation for the sun,
+    // neither needs a normal matrix
+    FragPos = vec3(model * vec4(aPos + aChunkOffset, 1.0));
+    Normal = aNormal;
     VertexColor = aColor;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
@@ -1,4 +1,5 @@
 #include "voxel.hpp"
+#include "gl_trace.hpp"
 
 #include <GL/glew.h>
 
@@ -124,17 +125,17 @@ namespace MC {
         if (s_vao == 0) {
             // Generate and bind the VAO
             glGenVertexArrays(1, &s_vao);
-            glBindVertexArray(s_vao);
+            GL::BindVertexArray(s_vao);
 
             // Generate and bind the VBO
             glGenBuffers(1, &s_vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, s_vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(VOXEL_VERTICES), VOXEL_VERTICES, GL_STATIC_DRAW);
+            GL::BindBuffer(GL_ARRAY_BUFFER, s_vbo);
+            GL::BufferData(GL_ARRAY_BUFFER, sizeof(VOXEL_VERTICES), VOXEL_VERTICES, GL_STATIC_DRAW);
 
             // Generate and bind the EBO
             glGenBuffers(1, &s_ebo);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_ebo);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(VOXEL_INDICES), VOXEL_INDICES, GL_STATIC_DRAW);
+            GL::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_ebo);
+            GL::BufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(VOXEL_INDICES), VOXEL_INDICES, GL_STATIC_DRAW);
 
             // Define the vertex attributes (position and normal)
             constexpr i32 POSITION_ATTRIB_INDEX = 0;
@@ -149,22 +150,22 @@ namespace MC {
             glEnableVertexAttribArray(NORMAL_ATTRIB_INDEX);
 
             // Unbind the VAO (optional for safety)
-            glBindVertexArray(0);
+            GL::BindVertexArray(0);
         }
     }
 
     void Voxel::CleanupStaticBuffers() {
         // Delete buffers only if they exist
         if (s_ebo != 0) {
-            glDeleteBuffers(1, &s_ebo);
+            GL::DeleteBuffer(s_ebo);
             s_ebo = 0;
         }
         if (s_vbo != 0) {
-            glDeleteBuffers(1, &s_vbo);
+            GL::DeleteBuffer(s_vbo);
             s_vbo = 0;
         }
         if (s_vao != 0) {
-            glDeleteVertexArrays(1, &s_vao);
+            GL::DeleteVertexArray(s_vao);
             s_vao = 0;
         }
     }
@@ -4,8 +4,8 @@
 
 
 namespace MC {
-	Window::Window(const std::string& title, i32 width, i32 height, EventHandler& event_handler)
-		: m_window_data(std::make_unique<WindowData>(title, width, height, event_handler)), m_running(true) {
+	Window::Window(const std::string& title, i32 width, i32 height, EventHandler& event_handler, WindowMode mode)
+		: m_window_data(std::make_unique<WindowData>(title, width, height, event_handler)), m_running(true), m_mode(mode) {
 		CreateWindow(width, height, title);
 		
 		// Subscribes to make sure window gets resized properly
@@ -14,15 +14,32 @@ namespace MC {
 
 	Window::~Window() { DestroyWindow(); }
 
-	void Window::CreateWindow(i32 width, i32 height, const std::string& title) {
+	namespace {
+		void SetContextHints() {
+			glfwDefaultWindowHints();
 
-		glfwInit();
+			// 4.3 for glMultiDrawElementsIndirect
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+			glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		}
+	}
 
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	void Window::CreateWindow(i32 width, i32 height, const std::string& title) {
+		if (m_mode == WindowMode::HEADLESS) {
+			m_window = CreateHeadlessContext(width, height, title);
+		}
+		else {
+			glfwInit();
+			SetContextHints();
+			m_window = glfwCreateWindow(m_window_data->width, m_window_data->height, m_window_data->title.c_str(), nullptr, nullptr);
+		}
+
+		if (!m_window) {
+			LOG_FATAL("Failed to create an OpenGL 4.3 context");
+			return;
+		}
 
-		m_window = glfwCreateWindow(m_window_data->width, m_window_data->height, m_window_data->title.c_str(), nullptr, nullptr);
 		glfwMakeContextCurrent(m_window);
 
 		// Turns off vsync
@@ -92,6 +109,8 @@ namespace MC {
 			data.event_handler.PublishEvent<MouseScrolledEvent>(std::make_shared<MouseScrolledEvent>(x, y));
 			});
 
+		// Needed for GLEW to load every entry point on a core profile
+		glewExperimental = GL_TRUE;
 		glewInit();
 
 		glEnable(GL_DEPTH_TEST); 
@@ -100,16 +119,97 @@ namespace MC {
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		glCullFace(GL_BACK);
 		glFrontFace(GL_CCW);
-		glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); 
+
+		if (m_mode == WindowMode::HEADLESS) {
+			CreateOffscreenTarget(width, height);
+		}
+		else {
+			glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		}
+	}
+
+	GLFWwindow* Window::CreateHeadlessContext(i32 width, i32 height, const std::string& title) {
+		// The null platform needs no display server at all, its contexts come from EGL or OSMesa,
+		// which fall back to llvmpipe on machines without a GPU. premake5.lua only links the Windows
+		// builds of GLFW, GLEW and FastNoise, a Linux box needs its own builds of those to get here
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+		if (glfwInit()) {
+			for (i32 context_api : { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API }) {
+				SetContextHints();
+				glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+				glfwWindowHint(GLFW_CONTEXT_CREATION_API, context_api);
+
+				if (GLFWwindow* window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr)) {
+					LOG_INFO("Headless context created through " << (context_api == GLFW_EGL_CONTEXT_API ? "EGL" : "OSMesa"));
+					return window;
+				}
+			}
+			glfwTerminate();
+		}
+
+		LOG_WARN("No display-less context available, falling back to a hidden window");
+		glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+		if (!glfwInit()) {
+			return nullptr;
+		}
+
+		SetContextHints();
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		return glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
+	}
+
+	void Window::CreateOffscreenTarget(i32 width, i32 height) {
+		glGenFramebuffers(1, &m_framebuffer);
+		glGenRenderbuffers(1, &m_color_renderbuffer);
+		glGenRenderbuffers(1, &m_depth_renderbuffer);
+		ResizeOffscreenTarget(width, height);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color_renderbuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth_renderbuffer);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			LOG_ERROR("Offscreen framebuffer is incomplete");
+		}
+
+		// Stays bound for the lifetime of the window, nothing else binds a framebuffer
+	}
+
+	void Window::ResizeOffscreenTarget(i32 width, i32 height) {
+		glBindRenderbuffer(GL_RENDERBUFFER, m_color_renderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_depth_renderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glViewport(0, 0, width, height);
+	}
+
+	void Window::DestroyOffscreenTarget() {
+		if (m_framebuffer == 0) {
+			return;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_color_renderbuffer);
+		glDeleteRenderbuffers(1, &m_depth_renderbuffer);
+		m_framebuffer = 0;
 	}
 
 	void Window::DestroyWindow() {
+		DestroyOffscreenTarget();
 		glfwDestroyWindow(m_window);
 		glfwTerminate();
 	}
 
 	void Window::Update() {
-		glfwSwapBuffers(m_window);
+		if (m_mode == WindowMode::HEADLESS) {
+			// Nothing to present, waiting for the GPU keeps the frame times honest
+			glFinish();
+		}
+		else {
+			glfwSwapBuffers(m_window);
+		}
 		glfwPollEvents();
 	}
 
@@ -122,6 +222,7 @@ namespace MC {
 			return m_running;
 
 		m_running = !glfwWindowShouldClose(m_window);
+		return m_running;
 	}
 
 	void Window::SetTitle(const std::string& title) {
@@ -132,10 +233,16 @@ namespace MC {
 	void Window::SetSize(i32 width, i32 height) {
 		m_window_data->width = width;
 		m_window_data->height = height;
+		if (m_mode == WindowMode::HEADLESS) {
+			ResizeOffscreenTarget(width, height);
+			return;
+		}
 		glfwSetWindowSize(m_window, m_window_data->width, m_window_data->height);
 	}
 
 	WindowData& Window::GetWindowData() const { return *m_window_data; }
 
 	GLFWwindow* Window::GetNativeWindow() const { return m_window; }
+
+	WindowMode Window::GetMode() const { return m_mode; }
 } // namespace Spark
\ No newline at end of file
@@ -8,6 +8,11 @@
 #include "event_handler.hpp"
 
 namespace MC {
+	enum class WindowMode {
+		WINDOWED,
+		HEADLESS // No visible window, everything is rendered to an offscreen framebuffer
+	};
+
 	struct WindowData {
 		WindowData(const std::string& title, i32 width, i32 height, EventHandler& event_handler) :
 			title(title),
@@ -23,7 +28,7 @@ namespace MC {
 
 	class Window {
 	public:
-		Window(const std::string& title, i32 width, i32 height, EventHandler& event_handler);
+		Window(const std::string& title, i32 width, i32 height, EventHandler& event_handler, WindowMode mode = WindowMode::WINDOWED);
 		~Window();
 		void           DestroyWindow();
 		void           Update();
@@ -33,14 +38,28 @@ namespace MC {
 		void           SetSize(i32 width, i32 height);
 		WindowData& GetWindowData() const;
 		GLFWwindow* GetNativeWindow() const;
+		WindowMode GetMode() const;
 
 	private:
 		void CreateWindow(i32 width, i32 height, const std::string& title);
 
+		// Tries a display-less EGL context, then OSMesa, then a hidden window on the native platform
+		GLFWwindow* CreateHeadlessContext(i32 width, i32 height, const std::string& title);
+
+		// Framebuffer the headless mode renders into instead of the default one
+		void CreateOffscreenTarget(i32 width, i32 height);
+		void ResizeOffscreenTarget(i32 width, i32 height);
+		void DestroyOffscreenTarget();
+
 	private:
 		GLFWwindow* m_window;
 		bool m_running;
 		std::unique_ptr<WindowData> m_window_data;
+		WindowMode m_mode;
+
+		u32 m_framebuffer = 0;
+		u32 m_color_renderbuffer = 0;
+		u32 m_depth_renderbuffer = 0;
 	};
 }
 
@@ -0,0 +1,144 @@
+#include "world_gen_profiler.hpp"
+#include "log.hpp"
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+namespace MC {
+    namespace {
+        struct AtomicStageStats {
+            std::atomic<u64> nanoseconds = 0;
+            std::atomic<u64> noise_samples = 0;
+            std::atomic<u64> runs = 0;
+        };
+
+        struct ProfilerState {
+            std::atomic<u64> chunks = 0;
+            std::atomic<u64> nanoseconds = 0;
+            std::atomic<u64> slowest_chunk_nanoseconds = 0;
+            std::array<std::atomic<u64>, static_cast<size_t>(ChunkGenClass::COUNT)> chunk_classes = {};
+            std::array<AtomicStageStats, WORLD_GEN_STAGE_COUNT> stages;
+        };
+
+        ProfilerState& GetProfilerState() {
+            static ProfilerState state;
+            return state;
+        }
+
+        const char* GetChunkGenClassName(ChunkGenClass chunk_class) {
+            switch (chunk_class) {
+            case ChunkGenClass::SKY:
+                return "sky";
+            case ChunkGenClass::SOLID:
+                return "solid";
+            case ChunkGenClass::MIXED:
+                return "mixed";
+            default:
+                return "unknown";
+            }
+        }
+    }
+
+    const char* GetWorldGenStageName(WorldGenStage stage) {
+        switch (stage) {
+        case WorldGenStage::BIOMES:
+            return "biomes";
+        case WorldGenStage::ELEVATION:
+            return "elevation";
+        case WorldGenStage::HEIGHTS:
+            return "heights";
+        case WorldGenStage::CAVES:
+            return "caves";
+        case WorldGenStage::GRAVEL:
+            return "gravel";
+        case WorldGenStage::VOXEL_FILL:
+            return "voxel fill";
+        case WorldGenStage::TREES:
+            return "trees";
+        case WorldGenStage::FEATURES:
+            return "features";
+        default:
+            return "unknown";
+        }
+    }
+
+    void WorldGenProfiler::AddChunk(const ChunkGenProfile& profile) {
+        ProfilerState& state = GetProfilerState();
+        state.chunks.fetch_add(1, std::memory_order_relaxed);
+        state.nanoseconds.fetch_add(profile.nanoseconds, std::memory_order_relaxed);
+        state.chunk_classes[static_cast<size_t>(profile.chunk_class)].fetch_add(1, std::memory_order_relaxed);
+
+        u64 slowest = state.slowest_chunk_nanoseconds.load(std::memory_order_relaxed);
+        while (profile.nanoseconds > slowest && !state.slowest_chunk_nanoseconds.compare_exchange_weak(slowest, profile.nanoseconds, std::memory_order_relaxed)) {
+        }
+
+        for (size_t stage = 0; stage < WORLD_GEN_STAGE_COUNT; ++stage) {
+            const WorldGenStageStats& stats = profile.stages[stage];
+            if (stats.runs == 0) {
+                continue;
+            }
+            state.stages[stage].nanoseconds.fetch_add(stats.nanoseconds, std::memory_order_relaxed);
+            state.stages[stage].noise_samples.fetch_add(stats.noise_samples, std::memory_order_relaxed);
+            state.stages[stage].runs.fetch_add(stats.runs, std::memory_order_relaxed);
+        }
+    }
+
+    WorldGenProfileTotals WorldGenProfiler::GetTotals() {
+        ProfilerState& state = GetProfilerState();
+        WorldGenProfileTotals totals;
+        totals.chunks = state.chunks.load(std::memory_order_relaxed);
+        totals.nanoseconds = state.nanoseconds.load(std::memory_order_relaxed);
+        totals.slowest_chunk_nanoseconds = state.slowest_chunk_nanoseconds.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < totals.chunk_classes.size(); ++i) {
+            totals.chunk_classes[i] = state.chunk_classes[i].load(std::memory_order_relaxed);
+        }
+        for (size_t stage = 0; stage < WORLD_GEN_STAGE_COUNT; ++stage) {
+            totals.stages[stage].nanoseconds = state.stages[stage].nanoseconds.load(std::memory_order_relaxed);
+            totals.stages[stage].noise_samples = state.stages[stage].noise_samples.load(std::memory_order_relaxed);
+            totals.stages[stage].runs = state.stages[stage].runs.load(std::memory_order_relaxed);
+        }
+        return totals;
+    }
+
+    void WorldGenProfiler::Reset() {
+        ProfilerState& state = GetProfilerState();
+        state.chunks = 0;
+        state.nanoseconds = 0;
+        state.slowest_chunk_nanoseconds = 0;
+        for (std::atomic<u64>& count : state.chunk_classes) {
+            count = 0;
+        }
+        for (AtomicStageStats& stats : state.stages) {
+            stats.nanoseconds = 0;
+            stats.noise_samples = 0;
+            stats.runs = 0;
+        }
+    }
+
+    void WorldGenProfiler::LogReport(const WorldGenProfileTotals& totals) {
+#ifdef __WORLDGEN_PROFILE__
+        if (totals.chunks == 0) {
+            LOG_INFO("World generation profile: no chunks generated");
+            return;
+        }
+
+        std::ostringstream classes;
+        for (size_t i = 0; i < totals.chunk_classes.size(); ++i) {
+            classes << (i ? ", " : "") << totals.chunk_classes[i] << ' ' << GetChunkGenClassName(static_cast<ChunkGenClass>(i));
+        }
+        LOG_INFO("World generation profile: " << totals.chunks << " chunks (" << classes.str() << "), "
+            << totals.nanoseconds / totals.chunks << " ns/chunk, slowest " << totals.slowest_chunk_nanoseconds << " ns");
+
+        // Per chunk over all chunks, so stages that most chunks skip weigh accordingly
+        for (size_t stage = 0; stage < WORLD_GEN_STAGE_COUNT; ++stage) {
+            const WorldGenStageStats& stats = totals.stages[stage];
+            f64 share = totals.nanoseconds ? 100.0 * stats.nanoseconds / totals.nanoseconds : 0.0;
+            LOG_INFO("  " << std::left << std::setw(11) << GetWorldGenStageName(static_cast<WorldGenStage>(stage)) << std::right
+                << std::setw(9) << stats.nanoseconds / totals.chunks << " ns/chunk " << std::fixed << std::setprecision(1) << std::setw(5) << share << "% | "
+                << std::setw(7) << stats.noise_samples / totals.chunks << " samples/chunk | ran in " << stats.runs << " chunks" << std::defaultfloat);
+        }
+#else
+        LOG_WARN("World generation profiling is not compiled into this build, nothing to report");
+#endif
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef WORLD_GEN_PROFILER_HPP
+#define WORLD_GEN_PROFILER_HPP
+
+#include "defines.hpp"
+#include "types.hpp"
+#include <array>
+#include <chrono>
+
+namespace MC {
+    enum class WorldGenStage : u32 {
+        BIOMES,         // Temperature and humidity lattice, upsampling and height curve blending
+        ELEVATION,      // Elevation octaves
+        HEIGHTS,        // Terrain height of every column
+        CAVES,          // Cave lattice and its interpolation
+        GRAVEL,
+        VOXEL_FILL,     // Per-voxel classification or the bulk fill of solid chunks
+        TREES,          // Tree noise and placement
+        FEATURES,       // Ore veins and lava pools
+        COUNT
+    };
+
+    constexpr size_t WORLD_GEN_STAGE_COUNT = static_cast<size_t>(WorldGenStage::COUNT);
+
+    const char* GetWorldGenStageName(WorldGenStage stage);
+
+    // How the chunk pre-pass classified a chunk
+    enum class ChunkGenClass : u32 {
+        SKY,
+        SOLID,
+        MIXED,
+        COUNT
+    };
+
+    struct WorldGenStageStats {
+        u64 nanoseconds = 0;
+        u64 noise_samples = 0;
+        u64 runs = 0;   // Chunks that ran the stage at all
+    };
+
+    struct ChunkGenProfile {
+        std::array<WorldGenStageStats, WORLD_GEN_STAGE_COUNT> stages = {};
+        ChunkGenClass chunk_class = ChunkGenClass::MIXED;
+        u64 nanoseconds = 0;
+    };
+
+    // Sums over every chunk generated since the last reset, on any thread
+    struct WorldGenProfileTotals {
+        u64 chunks = 0;
+        u64 nanoseconds = 0;
+        u64 slowest_chunk_nanoseconds = 0;
+        std::array<u64, static_cast<size_t>(ChunkGenClass::COUNT)> chunk_classes = {};
+        std::array<WorldGenStageStats, WORLD_GEN_STAGE_COUNT> stages = {};
+    };
+
+    // Per-stage timers and noise sample counters of chunk generation. Built with __WORLDGEN_PROFILE__ the
+    // generation stages report here, otherwise the totals stay zero
+    class WorldGenProfiler {
+    public:
+        // Adds one finished chunk to the totals, safe to call from any thread
+        static void AddChunk(const ChunkGenProfile& profile);
+
+        static WorldGenProfileTotals GetTotals();
+        static void Reset();
+
+        // Time per chunk and noise samples per chunk of every stage. Times add up over all worker threads
+        static void LogReport(const WorldGenProfileTotals& totals);
+    };
+
+    // Times the enclosing block into one stage of a chunk's profile
+    class WorldGenStageScope {
+    public:
+        WorldGenStageScope(ChunkGenProfile& profile, WorldGenStage stage, u64 noise_samples = 0)
+#ifdef __WORLDGEN_PROFILE__
+            : m_stats(profile.stages[static_cast<size_t>(stage)]), m_start(std::chrono::steady_clock::now()) {
+            m_stats.noise_samples += noise_samples;
+            ++m_stats.runs;
+        }
+#else
+        {
+        }
+#endif
+
+        ~WorldGenStageScope() {
+#ifdef __WORLDGEN_PROFILE__
+            m_stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+#endif
+        }
+
+        WorldGenStageScope(const WorldGenStageScope&) = delete;
+        WorldGenStageScope& operator=(const WorldGenStageScope&) = delete;
+
+#ifdef __WORLDGEN_PROFILE__
+    private:
+        WorldGenStageStats& m_stats;
+        std::chrono::steady_clock::time_point m_start;
+#endif
+    };
+
+    // Times a whole chunk and hands its profile to the WorldGenProfiler when it goes out of scope
+    class WorldGenChunkScope {
+    public:
+        WorldGenChunkScope()
+#ifdef __WORLDGEN_PROFILE__
+            : m_start(std::chrono::steady_clock::now())
+#endif
+        {
+        }
+
+        ~WorldGenChunkScope() {
+#ifdef __WORLDGEN_PROFILE__
+            m_profile.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+            WorldGenProfiler::AddChunk(m_profile);
+#endif
+        }
+
+        WorldGenChunkScope(const WorldGenChunkScope&) = delete;
+        WorldGenChunkScope& operator=(const WorldGenChunkScope&) = delete;
+
+        ChunkGenProfile& GetProfile() {
+            return m_profile;
+        }
+
+    private:
+        ChunkGenProfile m_profile;
+#ifdef __WORLDGEN_PROFILE__
+        std::chrono::steady_clock::time_point m_start;
+#endif
+    };
+}
+
+#endif // WORLD_GEN_PROFILER_HPP
@@ -0,0 +1,120 @@
+#include "world_hash.hpp"
+#include "event_handler.hpp"
+#include "log.hpp"
+#include "scene.hpp"
+#include "thread_pool.hpp"
+#include "world_gen_profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+namespace MC {
+    namespace {
+        // Ordered by x, then y, then z, the order the lines are written in
+        struct ChunkPositionLess {
+            bool operator()(const glm::ivec3& a, const glm::ivec3& b) const {
+                if (a.x != b.x) return a.x < b.x;
+                if (a.y != b.y) return a.y < b.y;
+                return a.z < b.z;
+            }
+        };
+
+        using ChunkHashes = std::map<glm::ivec3, u64, ChunkPositionLess>;
+
+        bool ReadChunkHashes(const std::string& path, ChunkHashes& hashes) {
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            std::string line;
+            while (std::getline(file, line)) {
+                std::istringstream stream(line);
+                glm::ivec3 chunk_pos;
+                u64 hash;
+                if (stream >> chunk_pos.x >> chunk_pos.y >> chunk_pos.z >> std::hex >> hash) {
+                    hashes[chunk_pos] = hash;
+                }
+            }
+            return true;
+        }
+    }
+
+    bool RunWorldHash(const WorldHashSettings& settings) {
+        u32 threads = settings.threads ? settings.threads : std::thread::hardware_concurrency();
+        glm::ivec3 min_chunk_pos(-settings.radius, settings.min_chunk_y, -settings.radius);
+        glm::ivec3 max_chunk_pos(settings.radius, settings.max_chunk_y, settings.radius);
+        LOG_INFO("World hash: seed " << settings.seed << ", chunks " << min_chunk_pos.x << ".." << max_chunk_pos.x << " x "
+            << min_chunk_pos.y << ".." << max_chunk_pos.y << " x " << min_chunk_pos.z << ".." << max_chunk_pos.z << " on " << threads << " threads");
+
+        ChunkHashes hashes;
+        {
+            ThreadPool tp(threads);
+            EventHandler event_handler(tp);
+            Scene scene(event_handler, tp);
+            scene.SetSeed(settings.seed);
+
+            WorldGenProfiler::Reset();
+            auto start = std::chrono::steady_clock::now();
+            scene.GenerateRegion(min_chunk_pos, max_chunk_pos);
+            std::chrono::duration<f64> elapsed = std::chrono::steady_clock::now() - start;
+
+            for (const auto& [chunk_pos, chunk] : scene.GetChunks()) {
+                hashes[chunk_pos] = chunk->ComputeContentHash();
+            }
+            LOG_INFO("Generated " << hashes.size() << " chunks in " << elapsed.count() << " s, " << hashes.size() / elapsed.count() << " chunks/s");
+            WorldGenProfiler::LogReport(WorldGenProfiler::GetTotals());
+        }
+
+        // One hash over every line for a quick comparison by eye
+        u64 region_hash = 0xcbf29ce484222325ull;
+        std::ofstream output(settings.output_path, std::ios::out | std::ios::trunc);
+        if (!output.is_open()) {
+            LOG_ERROR("Failed to open world hash output file: " << settings.output_path);
+        }
+        for (const auto& [chunk_pos, hash] : hashes) {
+            output << chunk_pos.x << ' ' << chunk_pos.y << ' ' << chunk_pos.z << ' ' << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << '\n';
+            region_hash = (region_hash ^ hash) * 0x100000001b3ull;
+        }
+        LOG_INFO("Region hash " << std::hex << std::setw(16) << std::setfill('0') << region_hash << std::dec << ", per-chunk hashes written to " << settings.output_path);
+
+        if (settings.golden_path.empty()) {
+            return true;
+        }
+
+        ChunkHashes golden;
+        if (!ReadChunkHashes(settings.golden_path, golden)) {
+            LOG_ERROR("Failed to open golden checksums: " << settings.golden_path);
+            return false;
+        }
+
+        size_t mismatches = 0;
+        size_t missing = 0;
+        for (const auto& [chunk_pos, hash] : hashes) {
+            auto golden_it = golden.find(chunk_pos);
+            if (golden_it == golden.end()) {
+                ++missing;
+            }
+            else if (golden_it->second != hash) {
+                if (mismatches < 10) {
+                    LOG_WARN("Chunk (" << chunk_pos.x << ", " << chunk_pos.y << ", " << chunk_pos.z << ") differs from the golden checksum");
+                }
+                ++mismatches;
+            }
+        }
+
+        if (missing > 0) {
+            LOG_WARN(missing << " chunks have no golden checksum, the golden file covers a different region");
+        }
+        if (mismatches > 0) {
+            LOG_ERROR(mismatches << " of " << hashes.size() << " chunks differ from " << settings.golden_path);
+            return false;
+        }
+        LOG_INFO("All " << hashes.size() - missing << " checked chunks match " << settings.golden_path);
+        return missing == 0;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef WORLD_HASH_HPP
+#define WORLD_HASH_HPP
+
+#include "types.hpp"
+#include <string>
+
+namespace MC {
+    struct WorldHashSettings {
+        u32 seed = 1337;
+        i32 radius = 4;         // Chunks on each side of the origin along x and z
+        i32 min_chunk_y = 0;
+        i32 max_chunk_y = 9;    // The highest terrain stays below y 160
+        u32 threads = 0;        // Thread pool size, 0 for one per hardware thread
+        std::string output_path = "world_hash.txt";
+        std::string golden_path; // Checked against when set
+    };
+
+    // Generates a fixed region of the world without any GL and writes one "x y z hash" line per chunk, sorted by
+    // position. Generation is deterministic for a seed whatever the thread count, so the file of a known good
+    // build serves as golden checksums. FastNoise picks its SIMD level at runtime, goldens should come from a
+    // machine with the same one. Returns false when a golden file is given and any chunk differs from it
+    bool RunWorldHash(const WorldHashSettings& settings = {});
+}
+
+#endif // WORLD_HASH_HPP
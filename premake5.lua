@@ -1,3 +1,13 @@
+newoption {
+    trigger = "gl-trace",
+    description = "Build the GL call tracing layer into Release as well"
+}
+
+newoption {
+    trigger = "worldgen-profile",
+    description = "Build the per-stage world generation profiler into Release as well"
+}
+
 workspace "MinecraftClone"
     architecture "x64"
     configurations { "Debug", "Release" }
@@ -47,4 +57,10 @@ project "MinecraftClone"
         defines { "NDEBUG", "_ITERATOR_DEBUG_LEVEL=0", "GLEW_STATIC" }
         runtime "Release"
         optimize "on"
-        links { "lib/FastNoise" }
\ No newline at end of file
+        links { "lib/FastNoise" }
+
+    filter "options:gl-trace"
+        defines { "GL_TRACE" }
+
+    filter "options:worldgen-profile"
+        defines { "WORLDGEN_PROFILE" }